@@ -0,0 +1,100 @@
+/*
+ * LED Anim -- animation files for Linux.  See LEDAnim.h
+ *
+ * Author: David Bryant <david@orangemoose.com>
+ */
+
+#if defined(__linux__)
+
+#include "Arduino.h"
+#include "LEDAnim.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+LEDAnimFile::LEDAnimFile()
+{
+  _map = NULL;
+  _mapSize = 0;
+}
+
+LEDAnimFile::~LEDAnimFile()
+{
+  close();
+}
+
+// Checks every op in the animation stays within size bytes and only uses colors
+// the palette has, so playing it can't read past the end of the file (or the
+// palette)
+static boolean validAnim(const byte *data, size_t size)
+{
+  if(size < LEDANIM_HEADER || data[0] != 'L' || data[1] != 'A' ||
+     data[2] != LEDANIM_VERSION) return false;
+  unsigned int leds = data[3] | (data[4] << 8);
+  unsigned int frames = data[5] | (data[6] << 8);
+  size_t colors = data[7] ? data[7] : 256;
+  size_t pos = LEDANIM_HEADER + 3*colors;
+  if(leds == 0 || frames == 0 || frames > 32767 || pos > size) return false;
+
+  for(unsigned int f=0;f<frames;f++) {
+    for(unsigned int i=0;i<leds;) {
+      if(pos >= size) return false;
+      byte op = data[pos++];
+      unsigned int count = (op & 0x3F) + 1;
+      size_t indexes;
+      switch(op & 0xC0) {
+        case LEDANIM_RUN:     indexes = 1; break;
+        case LEDANIM_LITERAL: indexes = count; break;
+        case LEDANIM_SKIP:    indexes = 0; break;
+        default: return false;
+      }
+      if(indexes > size - pos) return false;
+      for(size_t k=0;k<indexes;k++) {
+        if(data[pos++] >= colors) return false;
+      }
+      i += count;
+    }
+  }
+  return pos <= size;
+}
+
+// Maps the animation file at path, returning false if it can't be read or isn't
+// a complete animation
+boolean LEDAnimFile::open(const char *path)
+{
+  close();
+  int fd = ::open(path,O_RDONLY);
+  if(fd < 0) return false;
+
+  struct stat st;
+  void *map = MAP_FAILED;
+  if(fstat(fd,&st) == 0 && st.st_size > 0) {
+    map = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+  }
+  ::close(fd);
+  if(map == MAP_FAILED) return false;
+
+  _map = (byte *)map;
+  _mapSize = st.st_size;
+  if(!validAnim(_map,_mapSize)) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void LEDAnimFile::close()
+{
+  if(_map != NULL) munmap(_map,_mapSize);
+  _map = NULL;
+  _mapSize = 0;
+}
+
+// The animation, to pass to LEDControl::setAnimation()
+const byte *LEDAnimFile::data()
+{
+  return _map;
+}
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * LED Anim -- compressed frame-by-frame animations, for effects that can't be
+ * expressed as the built-in modes.  Played with LEDControl::setAnimation().
+ *
+ * An animation is a header, a palette of up to 256 colors, then the frames one
+ * after the other.  Each frame is a sequence of ops, each covering 1-64 LEDs
+ * (the count is the op's low 6 bits plus one), until every LED is covered:
+ *
+ *   0x00-0x3F  run      -- followed by one palette index, for all count LEDs
+ *   0x40-0x7F  literal  -- followed by count palette indexes, one per LED
+ *   0x80-0xBF  skip     -- count LEDs stay as they were in the previous frame
+ *
+ * Skips are what make delta frames: a frame only has to describe the LEDs
+ * that changed.  Decoding goes straight from the data into the LEDs, in time
+ * proportional to the compressed size.  The first frame is drawn over black.
+ *
+ * Header (multi-byte values are little endian):
+ *
+ *   0-1  'L' 'A'
+ *   2    version (LEDANIM_VERSION)
+ *   3-4  LEDs per frame
+ *   5-6  number of frames (at most 32767)
+ *   7    palette colors (0 means 256), followed by 3 bytes (r,g,b) for each
+ *
+ * On AVR animations are kept in PROGMEM.  extras/anim_encode converts raw RGB
+ * frames into this format, either as a file or as a PROGMEM array for a sketch.
+ *
+ * Author: David Bryant <david@orangemoose.com>
+ */
+
+#ifndef LEDAnim_h
+#define LEDAnim_h
+
+#include "Arduino.h"
+
+#define LEDANIM_VERSION  1
+#define LEDANIM_HEADER   8     // Bytes before the palette
+
+#define LEDANIM_RUN      0x00  // Op types, in the top two bits of each op
+#define LEDANIM_LITERAL  0x40
+#define LEDANIM_SKIP     0x80
+
+#if defined(__linux__)
+// Maps an animation file into memory, so it can be played straight from the
+// file with no loading or copying
+class LEDAnimFile
+{
+  public:
+    LEDAnimFile();
+    ~LEDAnimFile();
+    boolean open(const char *path);
+    void close();
+    const byte *data();
+  private:
+    byte *_map;
+    size_t _mapSize;
+};
+#endif
+
+#endif
@@ -18,6 +18,8 @@
 #include "Arduino.h"
 #include <FastLED.h>
 #include "LEDControl.h"
+#include "LEDPixel.h"
+#include "LEDEase.h"
 
 // Brightness map for dimming LEDs to simulate breathing.  Overall curve is a simple
 // parabola but offset 10 to keep the LEDs on (rather than going off).  For the math
@@ -25,16 +27,135 @@
 const static byte _dimming[] = {235,206,179,154,131,110,91,74,59,46,35,26,19,14,11,10};
 const static byte _numdims = 16;
 
-// Constructor class, mostly just saves key attributes
+// Spatial effects light LEDs within a band around a moving plane or sphere, fading
+// linearly with distance from it.  Coordinates and distances are all in the 0-255
+// range so the band width and per-tick step are in those units too.
+const static byte _bandwidth = 32;
+const static byte _sweepstep = 8;
+#define NO_ORIGIN 0xFFFFFFFFUL
+
+// Per-strip RAM adds up quickly in installations with lots of strips, so keep
+// an eye on it: anything only some strips need belongs in LEDExtras.  AVR packs
+// everything with no padding; 64-bit hosts need padding only at the end.
+#if defined(__AVR__)
+static_assert(sizeof(LEDControl) <= 32, "LEDControl has grown");
+#elif defined(__LP64__)
+static_assert(sizeof(LEDControl) <= 72, "LEDControl has grown");
+#endif
+
+// Registry of every strip, so they can all be updated together.  Fixed size so
+// no heap is needed; strips beyond LED_MAX_STRIPS still work, they just have to
+// be updated individually.
+LEDControl *LEDControl::_strips[LED_MAX_STRIPS];
+byte LEDControl::_numStrips = 0;
+unsigned long LEDControl::_globalTick = 0;
+
+// Constructor class, mostly just saves key attributes.  leds can be NULL for a
+// strip whose LEDs are generated as they're sent (see render()).
 LEDControl::LEDControl(int num_leds, CRGB leds[])
 {
+  if(_numStrips < LED_MAX_STRIPS) _strips[_numStrips++] = this;
   _ledCount = num_leds;
+  _span = num_leds;
+  _sectors = 1;
+  _dirtyFirst = 0;
+  _dirtyLast = num_leds-1;
+  _hwDimming = false;
+  _level = 255;
   _leds = leds;
+  _ext = NULL;
   _newMode = true;
   _mode = MODE_OFF;
   _color = CRGB::Black;  // off, essentially
-  _config = 0;
-  _curdir = 0;
+  _bitmap = 0;
+  _tick = 0;
+  _speed = 256;
+  _speedFrac = 0;
+  _paused = false;
+}
+
+// Gives the strip somewhere to keep the state for its optional features --
+// overlays, transitions, previews, the watchdog and the coordinate, distance
+// and frame caches -- which must stay around while the strip uses it.  Without
+// one (the default) those features are turned off: overlays can't be pushed,
+// transitions jump straight to their end, and the rest are ignored.  Sets the
+// block up from scratch, so any of those features already set up on the strip
+// have to be set up again.  Pass NULL to go back to having none.
+void LEDControl::setExtras(LEDExtras *extras)
+{
+  _ext = extras;
+  if(extras != NULL) {
+    *extras = LEDExtras();  // All zeros and NULLs
+    extras->cacheOrigin = NO_ORIGIN;
+    extras->tween.target = TWEEN_NONE;
+    extras->previewFirst = _ledCount;  // Nothing to preview yet
+    extras->previewLast = -1;
+    extras->lastUpdate = millis();
+  }
+  if(!_newMode) seek(_tick);  // Redraw, in case an overlay was showing
+}
+
+// Whether an overlay is covering the strip
+boolean LEDControl::_covered()
+{
+  return _ext != NULL && _ext->numOverlays > 0;
+}
+
+// Forgets any frames cached for the effect, as it's going to look different
+void LEDControl::_dropFrames()
+{
+  if(_ext != NULL) _ext->framesValid = false;
+}
+
+LEDControl::~LEDControl()
+{
+  for(int i=0;i<_numStrips;i++) {
+    if(_strips[i] == this) {
+      for(int j=i;j<_numStrips-1;j++) _strips[j] = _strips[j+1];
+      _numStrips--;
+      break;
+    }
+  }
+}
+
+// Updates every registered strip, in the order they were created
+void LEDControl::updateAll()
+{
+  LEDBatch::applyPending();
+  for(int i=0;i<_numStrips;i++) _strips[i]->update();
+  _globalTick++;
+}
+
+// Updates every registered strip, then has FastLED show them
+void LEDControl::showAll()
+{
+  updateAll();
+  FastLED.show();
+}
+
+int LEDControl::stripCount()
+{
+  return _numStrips;
+}
+
+// The i'th registered strip (in order of creation), or NULL
+LEDControl *LEDControl::getStrip(int i)
+{
+  if(i < 0 || i >= _numStrips) return NULL;
+  return _strips[i];
+}
+
+// Shared clock for all strips, counting calls to updateAll().  Boards driving
+// different parts of the same display can keep in step by agreeing on it, e.g.
+// one board sending its count to the others now and again via setGlobalTick().
+unsigned long LEDControl::globalTick()
+{
+  return _globalTick;
+}
+
+void LEDControl::setGlobalTick(unsigned long tick)
+{
+  _globalTick = tick;
 }
 
 // Returns the current operating mode (see LEDControl.h for values)
@@ -43,11 +164,49 @@ int LEDControl::getMode()
   return _mode;
 }
 
+// Sets any mode by number (see LEDControl.h), e.g. for modes chosen by a command
+// from elsewhere.  param carries the mode's extra setting if it has one: the
+// bitmap for Pattern and Marquee, the axis for Plane Sweep, the origin (packed
+// as z:y:x) for Radial Pulse, the scale for Noise, the waves (packed as
+// step2:step:stride2:stride) for Wave and the end color (packed as r:g:b) for
+// a two color Gradient.  Returns false if the mode isn't one that can be set
+// this way.
+boolean LEDControl::setMode(byte mode, CRGB color, unsigned long param)
+{
+  switch(mode) {
+    case MODE_OFF:     setOff(); break;
+    case MODE_ON:      setOneColor(color); break;
+    case MODE_RUNFWD:  setRunFwd(color); break;
+    case MODE_RUNREV:  setRunRev(color); break;
+    case MODE_RAINBF:  setRainbowFwd(); break;
+    case MODE_RAINBR:  setRainbowRev(); break;
+    case MODE_CYLON:   setCylon(color); break;
+    case MODE_BITMAP:  setPattern(color,param); break;
+    case MODE_MARQUEE: setMarquee(color,param); break;
+    case MODE_BREATHE: setBreathe(color); break;
+    case MODE_PLANE:   setPlaneSweep(color,param); break;
+    case MODE_RADIAL:  setRadialPulse(color,param,param >> 8,param >> 16); break;
+    case MODE_NOISE:   setNoise(param); break;
+    case MODE_WAVE:
+      setWave(color,param,param >> 16);
+      addWave(param >> 8,param >> 24);
+      break;
+    case MODE_GRADIENT: setGradient(color,CRGB(param >> 16,param >> 8,param)); break;
+    default: return false;
+  }
+  return true;
+}
+
+// All LEDs off
+void LEDControl::setOff()
+{
+  _startMode(MODE_OFF);
+}
+
 // All LEDs on, set to the same solid color
 void LEDControl::setOneColor(CRGB color)
 {
-  _newMode = true;
-  _mode = MODE_ON;
+  _startMode(MODE_ON);
   _color = color;
 }
 
@@ -55,8 +214,7 @@ void LEDControl::setOneColor(CRGB color)
 // Wraps around from end to beginning if left on long enough
 void LEDControl::setRunFwd(CRGB color)
 {
-  _newMode = true;
-  _mode = MODE_RUNFWD;
+  _startMode(MODE_RUNFWD);
   _color = color;
 }
 
@@ -65,37 +223,129 @@ void LEDControl::setRunFwd(CRGB color)
 // if left on long enough
 void LEDControl::setRunRev(CRGB color)
 {
-  _newMode = true;
-  _mode = MODE_RUNREV;
+  _startMode(MODE_RUNREV);
   _color = color;
 }
 
 // Loads the strip with a rainbow and then runs it forward
 void LEDControl::setRainbowFwd()
 {
-  _newMode = true;
-  _mode = MODE_RAINBF;
+  _startMode(MODE_RAINBF);
 }
 
 // Loads the strip with a rainbow and then runs it in reverse
 void LEDControl::setRainbowRev()
 {
+  _startMode(MODE_RAINBR);
+}
+
+// Colors the strip from a palette and cycles the colors along it by moving
+// through the palette rather than moving the LEDs.  LED i shows palette entry
+// i*stride + tick*step, wrapping round at the end of the palette (256 steps,
+// blended between entries for 16 entry palettes).  A stride of 0 has the whole
+// strip change color together; a negative step runs the colors forward.  The
+// palette has to stay around while it's in use, and changes to it show up
+// straight away.
+void LEDControl::setPaletteCycle(const CRGBPalette16 &palette, byte stride, int step)
+{
+  _startMode(MODE_PALETTE);
+  _pal.palette = &palette;
+  _pal.big = false;
+  _pal.stride = stride;
+  _pal.step = step;
+}
+
+void LEDControl::setPaletteCycle(const CRGBPalette256 &palette, byte stride, int step)
+{
+  _startMode(MODE_PALETTE);
+  _pal.palette = &palette;
+  _pal.big = true;
+  _pal.stride = stride;
+  _pal.step = step;
+}
+
+// Palette cycle through the hue wheel, i.e. rainbow colors.  The rainbow modes
+// are this with stride 256/n and step -256/n (forward) or 256/n (reverse) for
+// an n LED strip, apart from wrapping round at the end of the strip instead of
+// the end of the wheel when n doesn't divide 256.
+void LEDControl::setHueCycle(byte stride, int step)
+{
+  _startMode(MODE_PALETTE);
+  _pal.palette = NULL;
+  _pal.stride = stride;
+  _pal.step = step;
+}
+
+// Travelling sine wave of brightness in the given color: LED i is at phase
+// i*stride + tick*step (a full cycle being 256), so stride sets the wavelength
+// (256/stride LEDs) and step the speed, with negative steps running the wave
+// forward.  Brightness never drops below floor.
+void LEDControl::setWave(CRGB color, byte stride, int step, byte floor)
+{
+  _startMode(MODE_WAVE);
+  _color = color;
+  _wave.stride[0] = stride;
+  _wave.step[0] = step;
+  _wave.stride[1] = _wave.step[1] = 0;
+  _wave.floor = floor;
+}
+
+// Adds a second wave on top of the one set by setWave(), e.g. a long slow swell
+// with short fast ripples.  Brightness is the average of the two.  Replaces any
+// second wave already added; zero stride and step removes it.
+void LEDControl::addWave(byte stride, int step)
+{
+  if(_mode != MODE_WAVE) return;
   _newMode = true;
-  _mode = MODE_RAINBR;
+  _wave.stride[1] = stride;
+  _wave.step[1] = step;
+}
+
+// Switches to mode, to be drawn from its start at the next update.  Any
+// transition still running is dropped, as it was moving one of the old mode's
+// settings (which share space with the new one's).
+void LEDControl::_startMode(byte mode)
+{
+  _newMode = true;
+  _mode = mode;
+  if(_ext != NULL) _ext->tween.target = TWEEN_NONE;
+}
+
+// Fades smoothly from one color at the start of the strip to another at the end
+void LEDControl::setGradient(CRGB from, CRGB to)
+{
+  _startMode(MODE_GRADIENT);
+  _color = from;
+  _grad.stops = NULL;
+  _grad.count = 2;
+  _grad.end = to;
+}
+
+// Fades through count colors spread evenly along the strip, the first at the
+// start and the last at the end.  Like a solid color it's drawn just once, so
+// the stops aren't copied, but changes to them only show up when the gradient
+// is set again (or through tweenStop()).  No stops turns the strip off.
+void LEDControl::setGradient(CRGB stops[], byte count)
+{
+  if(stops == NULL || count == 0) {
+    setOff();
+    return;
+  }
+  _startMode(MODE_GRADIENT);
+  _grad.stops = stops;
+  _grad.count = count;
 }
 
 // Runs a color back and forth (a la a Cylon's red eye)
 void LEDControl::setCylon(CRGB color)
 {
-  _newMode = true;
-  _mode = MODE_CYLON;
+  _startMode(MODE_CYLON);
   _color = color;
 }
 
 void LEDControl::setPattern(CRGB color, unsigned long bitmap)
 {
-  _newMode = true;
-  _mode = MODE_BITMAP;
+  _startMode(MODE_BITMAP);
   _color = color;
   _bitmap = bitmap;
 }
@@ -106,247 +356,1537 @@ void LEDControl::setPattern(CRGB color, unsigned long bitmap)
 // is indicate starting from led #0 in the strip.
 void LEDControl::setProgress(CRGB color, int percent)
 {
-	_newMode = true;
-	_mode = MODE_BITMAP;
+	_startMode(MODE_BITMAP);
 	_color = color;
 	/* Use percent to calculate proper bitmap */
 	if(percent > 100) percent = 100;
 	if(percent < 0)   percent = 0;
-	int lit = (_ledCount*(percent))/100.0;
-	_bitmap = ((1UL<<lit)-1);
+	if(_ext != NULL) _ext->percent = percent;
+	_bitmap = _progressBits(percent);
+}
+
+// Progress bar that moves smoothly from where it is now to the new percentage
+// over the given number of ticks, following an easing curve (see LEDEase.h)
+void LEDControl::setProgress(CRGB color, int percent, unsigned int ticks, byte curve)
+{
+	if(_mode != MODE_BITMAP) {
+		setProgress(color,0);  // Start from empty
+	}
+	_color = color;
+	percent = constrain(percent,0,100);
+	_startTween(TWEEN_PROGRESS,(_ext != NULL) ? _ext->percent : 0,percent,ticks,curve);
+}
+
+// Bitmap with the first percent% of the (at most 32) LEDs lit
+unsigned long LEDControl::_progressBits(int percent)
+{
+	int lit = (_span*(percent))/100.0;
+	if(lit >= 32) return 0xFFFFFFFFUL;
+	return ((1UL<<lit)-1);
 }
 
 void LEDControl::setMarquee(CRGB color, unsigned long bitmap)
 {
-  _newMode = true;
-  _mode = MODE_MARQUEE;
+  _startMode(MODE_MARQUEE);
   _color = color;
   _bitmap = bitmap;	
 }
 
 void LEDControl::setBreathe(CRGB color)
 {
-	_newMode = true;
-	_mode = MODE_BREATHE;
-	_config = 0;
-	_curdir = MODE_RUNFWD;
+	_startMode(MODE_BREATHE);
 	_color = color;
 }
 
+// For LEDs with their own brightness control (e.g. APA102), leaves the LED
+// colors at full brightness in Breathe mode and just reports the brightness
+// via getDimming() for the output stage to send to the LEDs.  Saves rewriting
+// every LED each tick and keeps full color depth when dim.
+void LEDControl::setHardwareDimming(boolean enable)
+{
+  _hwDimming = enable;
+  _newMode = true;
+}
+
+// Brightness (0-255) the LEDs should be shown at when using hardware dimming
+byte LEDControl::getDimming()
+{
+  if(_hwDimming && _mode == MODE_BREATHE && !_covered()) return _level;
+  return 255;
+}
+
+// Supplies the physical position of every LED for the spatial effects, as three
+// separate arrays (one per axis) each holding one coordinate per LED scaled to
+// 0-255.  Arrays are expected to be in PROGMEM on AVR, where they'd otherwise eat
+// most of the RAM; a strip laid out in a plane can pass NULL for the Z axis.
+// Needs extras (see setExtras()) to keep them in.
+void LEDControl::setCoordinates(const byte xs[], const byte ys[], const byte zs[])
+{
+  if(_ext == NULL) return;
+  _ext->coords[AXIS_X] = xs;
+  _ext->coords[AXIS_Y] = ys;
+  _ext->coords[AXIS_Z] = zs;
+  _ext->cacheOrigin = NO_ORIGIN;
+  _ext->framesValid = false;
+}
+
+// Optional buffer (one byte per LED) used to remember each LED's distance from
+// the radial pulse origin, so it's only calculated again when the origin moves.
+// Needs extras.
+void LEDControl::setDistanceCache(byte cache[])
+{
+  if(_ext == NULL) return;
+  _ext->distCache = cache;
+  _ext->cacheOrigin = NO_ORIGIN;
+}
+
+// Optional buffer for keeping a whole cycle of an effect that repeats every few
+// ticks (runs, Cylon, Marquee, Breathe and the spatial sweeps), so each frame is
+// only calculated once and after that just copied to the LEDs.  size is how
+// many LEDs the buffer has room for: an effect is cached if its period times the
+// strip (or sector) length fits, e.g. 32 x the strip length covers Marquee,
+// Breathe and the sweeps.  Pass NULL to stop caching.  Needs extras.
+void LEDControl::setFrameCache(CRGB cache[], int size)
+{
+  if(_ext == NULL) return;
+  _ext->frames = cache;
+  _ext->framesSize = (cache != NULL) ? size : 0;
+  _ext->framesValid = false;
+}
+
+// Sweeps a band of color through the LEDs along the given axis (AXIS_X, etc)
+void LEDControl::setPlaneSweep(CRGB color, int axis)
+{
+  _startMode(MODE_PLANE);
+  _color = color;
+  _axis = constrain(axis,AXIS_X,AXIS_Z);
+}
+
+// Expands a ring of color outward from the given point
+void LEDControl::setRadialPulse(CRGB color, byte x, byte y, byte z)
+{
+  _startMode(MODE_RADIAL);
+  _color = color;
+  _origin = ((unsigned long)z << 16) | ((unsigned long)y << 8) | x;
+}
+
+// Colors the LEDs from 3D noise sampled at their positions, drifting over time.
+// Larger scale values give finer grained noise across the LED layout.
+void LEDControl::setNoise(byte scale)
+{
+  _startMode(MODE_NOISE);
+  _scale = scale;
+}
+
+// Plays a compressed frame-by-frame animation (see LEDAnim.h), one frame per
+// tick, looping at the end.  data is in PROGMEM on AVR; on Linux it can come
+// from LEDAnimFile.  Returns false if data isn't an animation this version can
+// play, or is for a longer strip than this one.  Frames build on the ones
+// before them, so running backwards or seeking means decoding again from the
+// first frame.
+boolean LEDControl::setAnimation(const byte data[])
+{
+  if(_leds == NULL || data == NULL || pgm_read_byte(data) != 'L' || pgm_read_byte(data+1) != 'A' ||
+     pgm_read_byte(data+2) != LEDANIM_VERSION) return false;
+  unsigned int leds = pgm_read_byte(data+3) | (pgm_read_byte(data+4) << 8);
+  unsigned int frames = pgm_read_byte(data+5) | (pgm_read_byte(data+6) << 8);
+  if(leds == 0 || leds > (unsigned int)_ledCount || frames == 0 || frames > 32767) return false;
+  _startMode(MODE_ANIM);
+  _anim.data = data;
+  return true;
+}
+
+// Splits the strip into the given number of mirror-image sectors.  Effects are
+// only calculated for the first sector, which is then reflected (alternately
+// reversed and forward) to fill the rest of the strip.  Two sectors gives a strip
+// that's symmetric about its center; one turns symmetry off.
+void LEDControl::setSymmetry(byte sectors)
+{
+  if(sectors < 1) sectors = 1;
+  if(sectors > _ledCount) sectors = _ledCount;
+  _sectors = sectors;
+  _span = (_ledCount + sectors - 1) / sectors;
+  if(_ext != NULL) {
+    _ext->cacheOrigin = NO_ORIGIN;  // Cached distances and frames are for the old length
+    _ext->framesValid = false;
+  }
+  _newMode = true;  // Restart the current effect at the new length
+}
 
 // Master update function, called once per strip each clock cycle to
 // do whatever is needed to sequence the strip ahead by one 'tick'.
 // Uses the current mode of the strip to figure out what to do.
+//
+// Every effect's position is its tick count since the mode was set (_tick),
+// so the first update after changing modes shows tick 0 and each update after
+// that moves the effect along by the speed set with setSpeed() -- normally one
+// tick per update.
 void LEDControl::update()
 {
-  int delta;
-  
-  switch(_mode) {
-    case MODE_UNDEF:
-      break; // Shouldn't happen, but whatever
-    
-    case MODE_OFF:
-      if(_newMode) {
-        // Turn LEDs all off
-        fill_solid(_leds,_ledCount,CRGB::Black);
-        _newMode = false;
-      }
-      break;
-    
-    case MODE_ON:
-      if(_newMode) {
-        fill_solid(_leds,_ledCount,_color);
-        _newMode = false;
-      }
-      break;
-    
-    case MODE_RUNFWD:
-      // If we're changing modes, light just the first LED
-      if(_newMode) {
-        fill_solid(_leds,_ledCount,CRGB::Black);  // May not want to do this
-        _leds[0] = _color;
-        _newMode = false;
-      }
-      else {
-        // if we're not changing modes, move the LED one down the strip
-        // (with rollover of last LED color to first LED
-        shiftFwd();
-      }
+  LEDExtras *x = _ext;
+  unsigned long start = (x != NULL && x->budget != 0) ? micros() : 0;
+  if(!_checkState()) _recover();
+  if(x != NULL) {
+    if(x->tickMillis != 0) _catchUp();
+    if(x->tween.target != TWEEN_NONE) _stepTween(x->tween);
+  }
+
+  if(_covered()) {
+    // The effect underneath keeps time while covered, but isn't drawn
+    if(_newMode) {
+      _tick = 0;
+      _speedFrac = 0;
+      _newMode = false;
+      _dropFrames();
+    }
+    else if(!_paused) {
+      _tick += _ticksThisUpdate();
+    }
+    _updateOverlays();
+  }
+  else if(_newMode) {
+    _tick = 0;
+    _speedFrac = 0;
+    _dropFrames();
+    _render();
+    _newMode = false;
+    _changed();
+  }
+  else if(!_paused && _speed != 0) {
+    long steps = _ticksThisUpdate();
+    if(steps != 0) {
+      _advance(steps);
+    }
+    else if(_mode == MODE_BREATHE && !_hwDimming && !isDegraded()) {
+      // Slower than one tick per update, so breathe between dimming levels
+      _render();
+      _changed();
+    }
+  }
+  if(x == NULL) return;
+  if(x->preview != NULL && --x->previewCountdown == 0) {
+    if(x->degraded) {
+      x->previewCountdown = 1;  // Put off until there's time
+    }
+    else {
+      _updatePreview();
+      x->previewCountdown = x->previewInterval;
+    }
+  }
+  if(x->budget != 0) {
+    unsigned long elapsed = micros() - start;
+    if(elapsed > x->budget) x->degraded = true;
+    else if(elapsed < x->budget/2) x->degraded = false;
+  }
+}
+
+// Watches over the strip's timing.  tickMillis is how often the sketch calls
+// update(): if it goes more than two ticks without doing so (e.g. stuck in
+// other code) isStalled() reports it, and when updates resume the effect is
+// moved on by the missed ticks so it stays in step with the clock.
+// budgetMicros is the most time an update should take: when one takes longer,
+// optional work (previews, and Breathe's blending between levels at slow
+// speeds) is skipped until updates are comfortably back within budget.  Zero
+// turns either off, as they are by default.  Needs extras (see setExtras()).
+//
+// Whatever the settings, every update() makes a quick check that the strip's
+// state is sane, and if it isn't (say after a stray pointer write) turns the
+// strip off and counts a fault rather than carrying on with garbage.
+void LEDControl::setWatchdog(unsigned int tickMillis, unsigned int budgetMicros)
+{
+  if(_ext == NULL) return;
+  _ext->tickMillis = tickMillis;
+  _ext->budget = budgetMicros;
+  _ext->lastUpdate = millis();
+  _ext->degraded = false;
+}
+
+// Whether update() is overdue, e.g. for a hardware watchdog or timer interrupt
+// to check up on the sketch
+boolean LEDControl::isStalled()
+{
+  return _ext != NULL && _ext->tickMillis != 0 &&
+         (uint32_t)(millis() - _ext->lastUpdate) >= 2UL*_ext->tickMillis;
+}
+
+// Whether updates are running over budget, so optional work is being skipped
+boolean LEDControl::isDegraded()
+{
+  return _ext != NULL && _ext->degraded;
+}
+
+// Times the strip's state has been found corrupt and the strip turned off.
+// Only counted for strips with extras.
+byte LEDControl::getFaults()
+{
+  return (_ext != NULL) ? _ext->faults : 0;
+}
+
+// Total ticks update() should have been called for but wasn't (as caught up)
+unsigned int LEDControl::getMissedTicks()
+{
+  return (_ext != NULL) ? _ext->missed : 0;
+}
+
+// Checks the state fields hold values the rest of the code can cope with.  Not
+// exhaustive, but cheap enough to do on every update.  Positions that move
+// (e.g. the Cylon eye) are worked out from the tick and so are always in range
+// as long as the lengths are right.
+boolean LEDControl::_checkState()
+{
+  LEDExtras *x = _ext;
+  return _mode < NUM_MODES &&
+         _ledCount > 0 && _sectors > 0 &&
+         _span == (_ledCount + _sectors - 1) / _sectors &&
+         (_mode != MODE_PLANE || _axis <= AXIS_Z) &&
+         (_mode != MODE_GRADIENT || _grad.count != 0) &&
+         (_mode != MODE_ANIM || _anim.data != NULL) &&
+         (x == NULL ||
+          (x->numOverlays <= LED_MAX_OVERLAYS &&
+           (x->tween.target == TWEEN_NONE ||
+            (x->tween.target <= TWEEN_STOP && x->tween.duration != 0)) &&
+           (x->preview == NULL || x->previewDecimation != 0)));
+}
+
+// Puts a strip with corrupt state into a safe one: off, with no symmetry,
+// overlays, transition or preview
+void LEDControl::_recover()
+{
+  if(_ledCount <= 0) _ledCount = 1;  // Best guess, at least stays in bounds
+  _mode = MODE_OFF;
+  _sectors = 1;
+  _span = _ledCount;
+  if(_ext != NULL) {
+    if(_ext->faults < 255) _ext->faults++;
+    _ext->numOverlays = 0;
+    _ext->overlayShown = 0;
+    _ext->tween.target = TWEEN_NONE;
+    _ext->preview = NULL;
+  }
+  _newMode = true;
+}
+
+// Catches the effect up with the clock if update() wasn't called for a while
+void LEDControl::_catchUp()
+{
+  LEDExtras *x = _ext;
+  unsigned long now = millis();
+  unsigned long gap = now - x->lastUpdate;
+  x->lastUpdate = now;
+  if(gap < 2UL*x->tickMillis || _newMode || _paused) return;
+
+  unsigned long missed = min(gap / x->tickMillis - 1,0x7FFFUL);
+  x->missed = (missed < 0xFFFFU - x->missed) ? x->missed + missed : 0xFFFFU;
+  long ticks = ((long)missed * _speed) / 256;
+  if(ticks == 0) return;
+  if(x->numOverlays > 0) _tick += ticks;  // Not shown, so just keep time
+  else seek(_tick + ticks);
+}
+
+// Speed is in 1/256ths of a tick per update, so keep the fraction left over
+// for the next update and return how many whole ticks to move on
+long LEDControl::_ticksThisUpdate()
+{
+  long acc = (long)_speedFrac + _speed;
+  long steps = (acc >= 0) ? acc / 256 : -((-acc + 255) / 256);
+  _speedFrac = acc - steps * 256;
+  return steps;
+}
+
+// Changes the strip's color smoothly over the given number of ticks, following an
+// easing curve (see LEDEase.h).  Works in any mode that uses a color.
+void LEDControl::tweenColor(CRGB color, unsigned int ticks, byte curve)
+{
+  unsigned long from = ((unsigned long)_color.r << 16) | ((unsigned long)_color.g << 8) | _color.b;
+  unsigned long to = ((unsigned long)color.r << 16) | ((unsigned long)color.g << 8) | color.b;
+  _startTween(TWEEN_COLOR,from,to,ticks,curve);
+}
+
+// Changes the animation speed (see setSpeed()) smoothly over the given number of
+// ticks, e.g. to have a marquee gradually speed up or coast to a stop
+void LEDControl::tweenSpeed(int speed, unsigned int ticks, byte curve)
+{
+  _startTween(TWEEN_SPEED,_speed,speed,ticks,curve);
+}
+
+// Changes the color of one of a gradient's stops smoothly over the given number
+// of ticks, e.g. to have a gradient slowly shift from warm to cool colors.
+// The new color is written into the stops array as it goes.
+void LEDControl::tweenStop(byte stop, CRGB color, unsigned int ticks, byte curve)
+{
+  if(_mode != MODE_GRADIENT || stop >= _grad.count) return;
+  CRGB c = _gradStop(stop);
+  unsigned long from = ((unsigned long)stop << 24) | ((unsigned long)c.r << 16) | ((unsigned long)c.g << 8) | c.b;
+  unsigned long to = ((unsigned long)color.r << 16) | ((unsigned long)color.g << 8) | color.b;
+  _startTween(TWEEN_STOP,from,to,ticks,curve);
+}
+
+// A strip has one transition at a time, so starting one replaces any other
+// still in progress (leaving that setting wherever it had got to).  Strips
+// without extras (see setExtras()) have nowhere to keep a transition, so just
+// go straight to the new value.
+void LEDControl::_startTween(byte target, long from, long to, unsigned int ticks, byte curve)
+{
+  LEDTween now;
+  LEDTween &tween = (_ext != NULL) ? _ext->tween : now;
+  tween.target = target;
+  tween.curve = curve;
+  tween.duration = (_ext != NULL) ? max(ticks,1U) : 1;
+  tween.elapsed = 0;
+  tween.from = from;
+  tween.to = to;
+  if(_ext == NULL) _stepTween(tween);
+}
+
+// Moves a transition on by one tick
+void LEDControl::_stepTween(LEDTween &tween)
+{
+  tween.elapsed++;
+  byte f = ease8(tween.curve,((unsigned long)tween.elapsed * 255) / tween.duration);
+  boolean redraw = false;
+
+  switch(tween.target) {
+    case TWEEN_COLOR: {
+      CRGB from = CRGB(tween.from >> 16,tween.from >> 8,tween.from);
+      CRGB to = CRGB(tween.to >> 16,tween.to >> 8,tween.to);
+      CRGB c = blend(from,to,f);
+      redraw = (c != _color);
+      _color = c;
+      _dropFrames();
       break;
-    
-    case MODE_RUNREV:
-      // If we're changing modes, light just the last LED
-      if(_newMode) {
-        fill_solid(_leds,_ledCount,CRGB::Black);  // May not want to do this
-        _leds[_ledCount-1] = _color;
-        _newMode = false;
-      }
-      else {
-        // if we're not changing modes, move the LED one up the strip
-        // (with rollover of first LED color to last LED
-        shiftRev();  // use the convenience function
-      }
+    }
+    case TWEEN_PROGRESS: {
+      if(_mode != MODE_BITMAP) break;  // _bitmap is another mode's settings now
+      int percent = tween.from + ((tween.to - tween.from) * f) / 255;
+      unsigned long bits = _progressBits(percent);
+      redraw = (bits != _bitmap);
+      _bitmap = bits;
+      if(_ext != NULL) _ext->percent = percent;
       break;
-    
-    case MODE_RAINBF:
-      // Just need to initialize the strip with a rainbow pattern
-      // then run it as MODE_RUNFWD
-      delta = 256 / _ledCount;
-      if(_newMode) {
-        // Load up the initial rainbow
-        for(int i=0;i<_ledCount;i++) {
-          _leds[i] = CHSV(i*delta,255,255);
-        }
-        _newMode = false;
-        _mode = MODE_RUNFWD;
-      }
-      else {
-        // Should never get here!
-        Serial.println("Rainbow fwd error");
-      }
+    }
+    case TWEEN_SPEED:
+      _speed = tween.from + ((tween.to - tween.from) * f) / 255;
       break;
-    
-    case MODE_RAINBR:
-      // Just need to initialize the strip with a rainbow pattern
-      // then run it as MODE_RUNREV
-      delta = 256 / _ledCount;
-      if(_newMode) {
-        // Load up the initial rainbow
-        for(int i=0;i<_ledCount;i++) {
-          _leds[i] = CHSV(i*delta,255,255);
-        }
-        _newMode = false;
-        _mode = MODE_RUNREV;
-      }
-      else {
-        // Should never get here!
-        Serial.println("Rainbow rev error");
-      }
+    case TWEEN_STOP: {
+      byte k = tween.from >> 24;  // Which stop
+      if(_mode != MODE_GRADIENT || k >= _grad.count) break;
+      CRGB from = CRGB(tween.from >> 16,tween.from >> 8,tween.from);
+      CRGB to = CRGB(tween.to >> 16,tween.to >> 8,tween.to);
+      CRGB c = blend(from,to,f);
+      CRGB &stop = _gradStop(k);
+      redraw = (c != stop);
+      stop = c;
       break;
+    }
+  }
+  if(tween.elapsed >= tween.duration) tween.target = TWEEN_NONE;
 
-    // Implement alternating forward & reverse runs.  Is careful to have
-    // a full cycle time equal to 2x the number of LEDs so it can stay in
-    // synch with regular single direction runs.
-    case MODE_CYLON:
-      if(_newMode) {
-        fill_solid(_leds,_ledCount,CRGB::Black);  // May not want to do this
-        _leds[0] = _color;
-        _curdir = MODE_RUNFWD;  // Need to keep track of movement direction
-        _newMode = false;        
-      }
-      else {
-        if(_curdir == MODE_RUNFWD)  {
-          // Moving the LED forward
-          // Are we at the end?
-          if(_leds[_ledCount-1] == _color){
-            _curdir = MODE_RUNREV;
-          }
-          else {
-            shiftFwd();
-          }
-        }
-        else {
-          // Moving the LED reverse
-          if(_leds[0] == _color) {
-            _curdir = MODE_RUNFWD;
-          }
-          else {
-            shiftRev();
-          }
-        }
-      }
-      break;
-    
-    case MODE_BITMAP:
-      if(_newMode) {
-        fill_solid(_leds,_ledCount,CRGB::Black);
-        int m = min(_ledCount,32);
-        unsigned long mask = 1;  // Is unsigned long
-        for(int i=0;i<m;i++) {
-          if( (_bitmap & (mask<<i)) != 0) { _leds[i] = _color; }
-        }
-        _newMode = false;
-      }
-      break;
+  // Redraw with the new setting, unless the LEDs are about to be drawn anyway
+  if(redraw && !_newMode && !_covered()) {
+    _render();
+    _changed();
+  }
+}
 
- 	case MODE_MARQUEE:
- 		if(_newMode) {
- 			fill_solid(_leds,_ledCount,CRGB::Black);
- 			int m = min(_ledCount,32);
- 			unsigned long mask = 1;
- 			for(int i=0;i<m;i++) {
-          		if( (_bitmap & (mask<<i)) != 0) { _leds[i] = _color; }
- 			}
- 			_newMode = false;
- 		}
- 		else {
- 			int m = min(_ledCount,32);
- 			_bitmap = (_bitmap << 1UL) | (_bitmap >> ((unsigned long)(m-1))) ;
- 			unsigned long mask = 1;
- 			for(int i=0;i<m;i++) {
-          		if( (_bitmap & (mask<<i)) != 0) { _leds[i] = _color; }
-          		else { _leds[i] = CRGB::Black; }
- 			}
- 		}
- 		break;
-
-	case MODE_BREATHE:
-		if(_newMode) {
-			// Don't need to do any special LED initialization for this effect
-			_newMode = false;
-			_curdir = MODE_RUNFWD;
-			_config = 0; //  Just to make sure
-		}
-
-		CRGB c = _color;  // Use the base color
-		c %= _dimming[_config];
-		fill_solid(_leds,_ledCount,c);
-
-		// Which way do we go next?
-		if(_curdir == MODE_RUNFWD) {
-			// Are we at the end of the dimming map?
-			if( _config == (_numdims-1) ) {
-			  // Yep, reverse direction, but do this dimming index twice
-			  _curdir = MODE_RUNREV;
-			}
-			else {
-			  // Nope, more dimming to do
-			  _config++;
-			}
-		}
-		else {
-			// Must be brightening, then. Are we at the beginning of the dimming map?
-			if( _config == 0) {
-				// Yep, reverse direction but do this dimming index twice
-				_curdir = MODE_RUNFWD;
-			}
-			else {
-				// Nope, more brightening to do
-				_config--;
-			}
-		}
-		break;
+// Writes a compact snapshot of the strip's animation (mode, color, pattern,
+// speed and how far it has run) into state, which must have room for
+// LED_STATE_SIZE bytes, e.g. to keep in EEPROM or flash and restore after a
+// power loss.  Things set up by pointer (coordinates, previews, etc) and
+// overlays aren't included.  Returns the number of bytes written.
+int LEDControl::saveState(byte state[])
+{
+  _packState(state);
+  _saved(state);
+  return LED_STATE_SIZE;
+}
 
-    default:
-      Serial.print("Unrecognized mode: "); Serial.println(_mode);
-      break;
+// Puts the strip back exactly as it was when the snapshot was taken, jumping
+// straight to the same point in the animation.  Returns false (leaving the strip
+// alone) if the snapshot isn't valid or is from an incompatible version, or is
+// of a mode that depends on data the snapshot can't hold (animations, palette
+// cycles and gradients).
+boolean LEDControl::restoreState(const byte state[])
+{
+  byte check = 0;
+  for(int i=0;i<LED_STATE_SIZE-1;i++) check += state[i];
+  if(state[0] != LED_STATE_VERSION || check != state[LED_STATE_SIZE-1] ||
+     state[1] >= NUM_MODES || state[1] == MODE_ANIM || state[1] == MODE_PALETTE ||
+     state[1] == MODE_GRADIENT) return false;
+
+  _mode = state[1];
+  _paused = (state[2] & 0x01) != 0;
+  _hwDimming = (state[2] & 0x02) != 0;
+  _color = CRGB(state[3],state[4],state[5]);
+  _bitmap = (unsigned long)state[6] | ((unsigned long)state[7] << 8) |
+            ((unsigned long)state[8] << 16) | ((unsigned long)state[9] << 24);
+  if(_mode == MODE_WAVE) _wave.floor = state[10];
+  setSymmetry(state[11]);
+  if(_ext != NULL) _ext->percent = state[12];
+  _speed = (int16_t)(state[13] | (state[14] << 8));
+  long tick = (int32_t)((uint32_t)state[15] | ((uint32_t)state[16] << 8) |
+                        ((uint32_t)state[17] << 16) | ((uint32_t)state[18] << 24));
+  if(_ext != NULL) _ext->tween.target = TWEEN_NONE;
+  _dropFrames();
+
+  seek(tick);
+  _saved(state);
+  return true;
+}
+
+// Remembers the settings in a snapshot just saved or restored, for needsSave()
+void LEDControl::_saved(const byte state[])
+{
+  if(_ext == NULL) return;
+  _ext->savedSum = _stateSum(state);
+  _ext->lastSave = millis();
+}
+
+// Whether it's worth saving a new snapshot -- only when the animation settings
+// (not just its position) have changed since the last save or restore, and not
+// more often than every minInterval milliseconds, to go easy on EEPROM/flash.
+// Needs extras (see setExtras()) to remember the last save; without them it's
+// always false.
+boolean LEDControl::needsSave(unsigned long minInterval)
+{
+  if(_ext == NULL || (uint32_t)(millis() - _ext->lastSave) < minInterval) return false;
+  byte state[LED_STATE_SIZE];
+  _packState(state);
+  return _stateSum(state) != _ext->savedSum;
+}
+
+// Snapshot layout (multi-byte values are little endian):
+//   0 version, 1 mode, 2 flags, 3-5 color, 6-9 mode settings, 10 unused,
+//   11 symmetry sectors, 12 progress percent, 13-14 speed, 15-18 tick,
+//   19 checksum
+void LEDControl::_packState(byte state[])
+{
+  state[0] = LED_STATE_VERSION;
+  state[1] = _mode;
+  state[2] = (_paused ? 0x01 : 0) | (_hwDimming ? 0x02 : 0);
+  state[3] = _color.r;
+  state[4] = _color.g;
+  state[5] = _color.b;
+  for(int i=0;i<4;i++) state[6+i] = _bitmap >> (8*i);
+  state[10] = (_mode == MODE_WAVE) ? _wave.floor : 0;  // Rest of the wave settings are in the bitmap
+  state[11] = _sectors;
+  state[12] = (_ext != NULL) ? _ext->percent : 0;
+  state[13] = _speed & 0xFF;
+  state[14] = (_speed >> 8) & 0xFF;
+  for(int i=0;i<4;i++) state[15+i] = _tick >> (8*i);
+  byte check = 0;
+  for(int i=0;i<LED_STATE_SIZE-1;i++) check += state[i];
+  state[LED_STATE_SIZE-1] = check;
+}
+
+// Fletcher checksum of the settings part of a snapshot (everything before the
+// tick), used to spot when they've changed
+unsigned int LEDControl::_stateSum(const byte state[])
+{
+  byte a = 0, b = 0;
+  for(int i=0;i<15;i++) {
+    a += state[i];
+    b += a;
   }
+  return (b << 8) | a;
 }
 
-void LEDControl::shiftFwd()
+// Temporarily covers the whole strip with a notification (e.g. "battery low")
+// in the given color.  The overlay lasts for duration updates (0 for until it's
+// removed with popOverlay()), and blinks onTicks on then offTicks off if
+// offTicks isn't 0.  Several overlays can be stacked, with the highest priority
+// one shown; pushing one with the same priority as an existing one replaces
+// it.  The strip's own effect carries on running underneath, so when the last
+// overlay goes the effect reappears exactly where it would have been anyway.
+// Returns false if there are already LED_MAX_OVERLAYS overlays, or the strip
+// has no extras (see setExtras()) to keep them in.
+boolean LEDControl::pushOverlay(byte priority, CRGB color, unsigned int duration, byte onTicks, byte offTicks)
 {
-  CRGB last = _leds[_ledCount-1];
-  for(int i=_ledCount-1;i>0;i--) {
-    _leds[i] = _leds[i-1];
+  LEDExtras *x = _ext;
+  if(x == NULL) return false;
+  int i;
+  for(i=0;i<x->numOverlays && x->overlays[i].priority < priority;i++) ;
+  if(i == x->numOverlays || x->overlays[i].priority != priority) {
+    if(x->numOverlays == LED_MAX_OVERLAYS) return false;
+    for(int j=x->numOverlays;j>i;j--) { x->overlays[j] = x->overlays[j-1]; }
+    x->numOverlays++;
   }
-  _leds[0] = last;
+  LEDOverlay &o = x->overlays[i];
+  o.priority = priority;
+  o.color = color;
+  o.ticksLeft = duration;
+  o.onTicks = max(onTicks,(byte)1);
+  o.offTicks = offTicks;
+  o.blink = 0;
+  x->overlayShown = 0;  // Make sure it gets drawn
+  _drawOverlay();
+  return true;
 }
 
-void LEDControl::shiftRev()
+// Removes the overlay with the given priority, if there is one
+void LEDControl::popOverlay(byte priority)
+{
+  if(_ext == NULL) return;
+  for(int i=0;i<_ext->numOverlays;i++) {
+    if(_ext->overlays[i].priority == priority) {
+      _removeOverlay(i);
+      return;
+    }
+  }
+}
+
+void LEDControl::clearOverlays()
+{
+  while(_covered()) _removeOverlay(_ext->numOverlays-1);
+}
+
+boolean LEDControl::hasOverlay()
+{
+  return _covered();
+}
+
+// Takes an overlay off the stack, putting the effect underneath back (as it
+// should look by now) if it was the last one.  A mode set while covered hasn't
+// started yet, so that's left for the next update() to start from tick 0.
+void LEDControl::_removeOverlay(int i)
+{
+  LEDExtras *x = _ext;
+  for(int j=i;j<x->numOverlays-1;j++) { x->overlays[j] = x->overlays[j+1]; }
+  x->numOverlays--;
+  if(x->numOverlays > 0) {
+    _drawOverlay();
+  }
+  else {
+    x->overlayShown = 0;
+    if(!_newMode) seek(_tick);
+  }
+}
+
+// Runs the overlays' timers (expiring any that are done) and blinking
+void LEDControl::_updateOverlays()
+{
+  LEDExtras *x = _ext;
+  for(int i=x->numOverlays-1;i>=0;i--) {
+    LEDOverlay &o = x->overlays[i];
+    if(o.offTicks != 0 && ++o.blink >= o.onTicks + o.offTicks) o.blink = 0;
+    if(o.ticksLeft != 0 && --o.ticksLeft == 0) {
+      _removeOverlay(i);
+      if(x->numOverlays == 0) return;
+    }
+  }
+  _drawOverlay();
+}
+
+// Shows the top overlay, only touching the LEDs when it's changed
+void LEDControl::_drawOverlay()
+{
+  LEDExtras *x = _ext;
+  LEDOverlay &o = x->overlays[x->numOverlays-1];
+  boolean lit = (o.blink < o.onTicks);
+  unsigned int shown = ((o.priority << 1) | lit) + 1;
+  if(shown == x->overlayShown) return;
+  if(_leds != NULL) fill_solid(_leds,_ledCount,lit ? o.color : CRGB(CRGB::Black));
+  x->overlayShown = shown;
+  _markDirty(0,_ledCount-1);
+}
+
+// Sets how fast effects run, as a fixed point multiple of 256: 256 is one tick
+// per update (the default), 128 half speed, 512 double, and negative values run
+// the effect backwards.  Fractional speeds still move smoothly where the effect
+// allows (e.g. Breathe), rather than just holding frames.
+void LEDControl::setSpeed(int speed)
+{
+  _speed = speed;
+}
+
+int LEDControl::getSpeed()
+{
+  return _speed;
+}
+
+// Freezes the current effect where it is; update() then changes nothing
+void LEDControl::pause()
+{
+  _paused = true;
+}
+
+void LEDControl::resume()
+{
+  _paused = false;
+}
+
+boolean LEDControl::isPaused()
+{
+  return _paused;
+}
+
+// Moves the effect on (or, if negative, back) by the given number of ticks
+// right away, whether paused or not.  Handy for single stepping when paused.
+// While an overlay is up the effect just keeps time, as in update().
+void LEDControl::step(int ticks)
+{
+  if(_newMode) update();  // Get the effect started first
+  if(_covered()) _tick += ticks;  // Not shown, so just keep time
+  else _advance(ticks);
+}
+
+// Jumps straight to the given tick of the current effect, as if it had been
+// running that long since the mode was set.  While an overlay is up only the
+// tick changes; the effect is drawn when the last overlay goes.
+void LEDControl::seek(long tick)
+{
+  if(_newMode) _dropFrames();
+  _newMode = false;
+  _tick = tick;
+  _speedFrac = 0;
+  if(_covered()) return;
+  _render();
+  _changed();
+}
+
+// Ticks the current effect has run since its mode was set
+long LEDControl::getTick()
+{
+  return _tick;
+}
+
+// Works out the colors of count LEDs, starting with LED first, into chunk.  Lets
+// output stages generate LEDs a few at a time just as they're sent, so a strip
+// set up without an LED array (passing NULL to the constructor) needs no RAM
+// per LED at all.  Not for animations, whose frames have to be kept.
+void LEDControl::render(CRGB chunk[], int first, int count)
+{
+  if(!_covered() && (_mode == MODE_OFF || _mode == MODE_ON || _mode == MODE_BREATHE)) {
+    fill_solid(chunk,count,_pixelAt(0));  // Same color all along
+    return;
+  }
+  if(!_covered() && _sectors == 1 && _mode == MODE_GRADIENT) {
+    _drawGradient(chunk,first,count);  // Interpolates along the chunk
+    return;
+  }
+  for(int k=0;k<count;k++) chunk[k] = pixel(first+k);
+}
+
+// Hands the whole strip to sink a tile of up to tileSize LEDs at a time, e.g.
+// for an output stage or compositor to work on while the tile is still in
+// cache.  sink is called as sink(strip, tile, first, count, context) for LEDs
+// first to first+count-1.  For processing that looks at neighboring LEDs (e.g.
+// a blur) each tile comes with up to halo LEDs either side, as tile[-1] and
+// tile[count] and so on, wherever the strip has them.
+//
+// Strips without an LED array have each tile generated into scratch, which
+// needs room for tileSize + 2*halo LEDs, so memory use doesn't depend on the
+// length of the strip.  Otherwise tiles are just pieces of the LED array and
+// scratch isn't used.  Does nothing if tileSize isn't at least 1.
+void LEDControl::renderTiles(CRGB scratch[], int tileSize, byte halo, LEDTileCallback sink, void *context)
+{
+  if(tileSize < 1) return;
+  for(int first=0;first<_ledCount;first+=tileSize) {
+    int count = min(tileSize,_ledCount-first);
+    if(_leds != NULL) {
+      sink(*this,_leds+first,first,count,context);
+      continue;
+    }
+    int lo = max(first-(int)halo,0);
+    int hi = min(first+count+(int)halo,_ledCount);
+    render(scratch,lo,hi-lo);
+    sink(*this,scratch+(first-lo),first,count,context);
+  }
+}
+
+// Puts the current effect where it would be had it started at the given global
+// tick (see globalTick()), so strips set up at different times run in step.
+// origin is what globalTick() returned when the effect was set (or its batch
+// committed): the updateAll() that follows draws tick 0 of it, which is when
+// the strip is at tick globalTick() - origin - 1 between updates.
+void LEDControl::setPhaseOrigin(unsigned long origin)
+{
+  seek((long)(_globalTick - origin) - 1);
+}
+
+// Puts the current effect at the same point in its cycle as another strip's
+void LEDControl::alignTo(LEDControl &other)
+{
+  seek(other.getTick());
+}
+
+// Color LED i should be showing now, worked out from the effect's settings and
+// tick alone (so it doesn't need the LED buffer).  Matches what update() draws.
+CRGB LEDControl::pixel(int i)
+{
+  if(i < 0 || i >= _ledCount) return CRGB::Black;
+  if(_covered()) {
+    LEDOverlay &o = _ext->overlays[_ext->numOverlays-1];
+    return (o.blink < o.onTicks) ? o.color : CRGB(CRGB::Black);
+  }
+  if(_sectors == 2) {
+    if(i >= _span) i = _ledCount-1-i;
+  }
+  else if(_sectors > 1) {
+    int k = i % _span;
+    i = ((i / _span) & 1) ? _span-1-k : k;
+  }
+  return _pixelAt(i);
+}
+
+// Moves the effect along by steps ticks (backwards if negative), updating the
+// LEDs incrementally where the effect allows and redrawing them otherwise
+void LEDControl::_advance(long steps)
+{
+  long from = _tick;
+  _tick += steps;
+
+  switch(_mode) {
+    case MODE_UNDEF:
+    case MODE_OFF:
+    case MODE_ON:
+    case MODE_BITMAP:
+    case MODE_GRADIENT:
+      return;  // Static, nothing to do
+
+    case MODE_RAINBF:
+      _rotate(steps);
+      break;
+
+    case MODE_RAINBR:
+      _rotate(-steps);
+      break;
+
+    // Just move the one lit LED, so only the LEDs between the old and new
+    // positions count as changed
+    case MODE_RUNFWD:
+    case MODE_RUNREV:
+    case MODE_CYLON: {
+      int was = _litPos(from);
+      int now = _litPos(_tick);
+      if(_leds != NULL) {
+        _leds[was] = CRGB::Black;
+        _leds[now] = _color;
+      }
+      _changed(min(was,now),max(was,now));
+      return;
+    }
+
+    // Marquee LEDs past the bitmap stay dark
+    case MODE_MARQUEE:
+      _render();
+      _changed(0,min(_span,32)-1);
+      return;
+
+    case MODE_BREATHE:
+      if(_hwDimming) {
+        _level = _breatheLevel();  // LEDs themselves don't change
+        return;
+      }
+      _render();
+      break;
+
+    case MODE_ANIM: {
+      // Carry on decoding from the frame already on the LEDs
+      unsigned int frames = pgm_read_byte(_anim.data+5) | (pgm_read_byte(_anim.data+6) << 8);
+      _playTo(_phase(_tick,frames),false);
+      break;
+    }
+
+    default:
+      _render();
+      break;
+  }
+  _changed();
+}
+
+// Draws the current effect from scratch as it should look at tick _tick
+void LEDControl::_render()
+{
+  if(_leds == NULL) {
+    // Streaming, so nothing to draw (see render())
+    _level = _breatheLevel();
+    return;
+  }
+  int period = _cachePeriod();
+  if(period == 0) {
+    _draw();
+    return;
+  }
+  if(!_ext->framesValid) _fillCache(period);
+  _level = _breatheLevel();
+  memcpy(_leds,_ext->frames + (long)_phase(_tick,period)*_span,_span*sizeof(CRGB));
+}
+
+// How many ticks the current effect takes to repeat, if it can be played from
+// the frame cache, otherwise 0
+int LEDControl::_cachePeriod()
+{
+  if(_ext == NULL || _ext->frames == NULL || _ext->tween.target == TWEEN_COLOR) return 0;
+
+  int period;
+  switch(_mode) {
+    case MODE_RUNFWD:
+    case MODE_RUNREV:
+    case MODE_RAINBF:
+    case MODE_RAINBR:
+      period = _span;
+      break;
+    case MODE_CYLON:
+      period = 2*_span;
+      break;
+    case MODE_MARQUEE:
+      period = min(_span,32);
+      break;
+    case MODE_BREATHE:
+      if(_hwDimming || _speedFrac != 0) return 0;  // Nothing to cache, or in between frames
+      period = 32;
+      break;
+    case MODE_PLANE:
+    case MODE_RADIAL:
+      period = 256 / _sweepstep;
+      break;
+    case MODE_WAVE:
+      period = max(_stepPeriod(_wave.step[0]),_stepPeriod(_wave.step[1]));
+      break;
+    default:
+      return 0;  // Static, or never repeats
+  }
+  return ((long)period * _span <= _ext->framesSize) ? period : 0;
+}
+
+// Stop k of the gradient.  Two color gradients keep their stops in the strip:
+// the start color is the strip's color (so tweenColor() works on it too).
+CRGB &LEDControl::_gradStop(byte k)
+{
+  if(_grad.stops != NULL) return _grad.stops[k];
+  return (k == 0) ? _color : _grad.end;
+}
+
+// LED that gradient stop k falls on
+int LEDControl::_gradPos(byte k)
+{
+  return ((long)k * (_span-1)) / (_grad.count-1);
+}
+
+// Draws LEDs first to first+count-1 of the gradient into out.  Between each
+// pair of stops the color channels are 16.16 fixed point values that just have
+// the step per LED added at each LED, so the divides are only done once per
+// stop rather than once per LED.
+void LEDControl::_drawGradient(CRGB out[], int first, int count)
+{
+  byte n = _grad.count;
+  if(n == 1 || _span == 1) {
+    fill_solid(out,count,_gradStop(n-1));
+    return;
+  }
+  int end = first + count;
+  int a = 0;
+  for(byte k=0;k+1<n && a<end;k++) {
+    int b = _gradPos(k+1);
+    int lo = max(a,first), hi = min(b,end);
+    if(lo < hi) {
+      CRGB from = _gradStop(k), to = _gradStop(k+1);
+      int32_t dr = (int32_t)(to.r - from.r) * 65536 / (b-a);
+      int32_t dg = (int32_t)(to.g - from.g) * 65536 / (b-a);
+      int32_t db = (int32_t)(to.b - from.b) * 65536 / (b-a);
+      int32_t r = ((int32_t)from.r << 16) + 0x8000 + (lo-a)*dr;  // Rounded
+      int32_t g = ((int32_t)from.g << 16) + 0x8000 + (lo-a)*dg;
+      int32_t bl = ((int32_t)from.b << 16) + 0x8000 + (lo-a)*db;
+      CRGB *p = out + (lo-first);
+      for(int i=lo;i<hi;i++) {
+        *p++ = CRGB(r >> 16,g >> 16,bl >> 16);
+        r += dr;
+        g += dg;
+        bl += db;
+      }
+    }
+    a = b;
+  }
+  if(end >= _span && first < _span) out[_span-1-first] = _gradStop(n-1);  // Last stop
+}
+
+// Ticks for a phase moving step (mod 256) a tick to come back round: 256 over
+// the largest power of 2 dividing step
+int LEDControl::_stepPeriod(byte step)
+{
+  if(step == 0) return 1;
+  int period = 256;
+  while((step & 1) == 0) {
+    step >>= 1;
+    period >>= 1;
+  }
+  return period;
+}
+
+// Draws every frame of the effect's cycle into the frame cache
+void LEDControl::_fillCache(int period)
+{
+  CRGB *leds = _leds;
+  long tick = _tick;
+  for(int f=0;f<period;f++) {
+    _leds = _ext->frames + (long)f*_span;
+    _tick = f;
+    _draw();
+  }
+  _leds = leds;
+  _tick = tick;
+  _ext->framesValid = true;
+}
+
+// Draws the frame for the current tick straight to the LEDs
+void LEDControl::_draw()
+{
+  switch(_mode) {
+    case MODE_UNDEF:
+      break; // Shouldn't happen, but whatever
+
+    // Whole strip the same color
+    case MODE_OFF:
+    case MODE_ON:
+    case MODE_BREATHE:
+      _level = _breatheLevel();
+      fill_solid(_leds,_span,_pixelAt(0));
+      break;
+
+    // Just one LED lit
+    case MODE_RUNFWD:
+    case MODE_RUNREV:
+    case MODE_CYLON:
+      fill_solid(_leds,_span,CRGB::Black);
+      _leds[_litPos(_tick)] = _color;
+      break;
+
+    case MODE_BITMAP:
+      _drawBitmap(_bitmap);
+      break;
+
+    case MODE_GRADIENT:
+      _drawGradient(_leds,0,_span);
+      break;
+
+    case MODE_MARQUEE:
+      _drawBitmap(_marqueeBits());
+      break;
+
+    case MODE_RADIAL:
+      if(_ext != NULL && _ext->distCache != NULL && _ext->cacheOrigin != _origin) {
+        for(int i=0;i<_span;i++) { _ext->distCache[i] = _distance(i); }
+        _ext->cacheOrigin = _origin;
+      }
+      // Fall through
+
+    case MODE_PALETTE:
+    case MODE_PLANE:
+    case MODE_NOISE:
+      for(int i=0;i<_span;i++) { _leds[i] = _pixelAt(i); }
+      break;
+
+    // Waves keep a phase for each wave and just add the stride to it at each
+    // LED, both waves in the one pass
+    case MODE_WAVE: {
+      byte a = _tick * _wave.step[0];
+      byte b = _tick * _wave.step[1];
+      const byte sa = _wave.stride[0], sb = _wave.stride[1];
+      for(int i=0;i<_span;i++) {
+        _leds[i] = _waveColor(a,b);
+        a += sa;
+        b += sb;
+      }
+      break;
+    }
+
+    // Rainbows are two runs of evenly spaced hues, either side of where the
+    // hues wrap round
+    case MODE_RAINBF:
+    case MODE_RAINBR: {
+      byte delta = 256/_span;
+      int p = _phase((_mode == MODE_RAINBF) ? -_tick : _tick,_span);
+      led_rainbow(_leds,_span-p,p*delta,delta);
+      led_rainbow(_leds+_span-p,p,0,delta);
+      break;
+    }
+
+    case MODE_ANIM: {
+      unsigned int frames = pgm_read_byte(_anim.data+5) | (pgm_read_byte(_anim.data+6) << 8);
+      _playTo(_phase(_tick,frames),true);
+      break;
+    }
+
+    default:
+      Serial.print("Unrecognized mode: "); Serial.println(_mode);
+      break;
+  }
+}
+
+// Color of LED i (within the first sector) at tick _tick.  This is what defines
+// each effect: every one is a function of just its settings, the strip length
+// and the tick, with no dependence on what the LEDs showed before.  _render()
+// takes shortcuts for some effects but always draws the same thing.
+CRGB LEDControl::_pixelAt(int i)
+{
+  switch(_mode) {
+    case MODE_ON:
+      return _color;
+
+    // Runs light just the first (or for reverse, last) LED at tick 0 and then
+    // move it one LED along the strip each tick, rolling over at the end.
+    // Cylons alternate forward & reverse runs.  Are careful to have a full
+    // cycle time equal to 2x the number of LEDs so they can stay in synch with
+    // regular single direction runs (the LEDs at each end are lit for two ticks).
+    case MODE_RUNFWD:
+    case MODE_RUNREV:
+    case MODE_CYLON:
+      return (i == _litPos(_tick)) ? _color : CRGB(CRGB::Black);
+
+    // Rainbows start with the strip full of a rainbow, then run it forward or
+    // reverse just like a regular run.  They're palette cycles through the hue
+    // wheel, one trip round the wheel along the strip.
+    case MODE_RAINBF:
+    case MODE_RAINBR:
+    case MODE_PALETTE:
+      return _paletteColor(_paletteIndex(i));
+
+    case MODE_BITMAP:
+      return (i < 32 && (_bitmap & (1UL<<i)) != 0) ? _color : CRGB(CRGB::Black);
+
+    case MODE_MARQUEE:
+      return (i < 32 && (_marqueeBits() & (1UL<<i)) != 0) ? _color : CRGB(CRGB::Black);
+
+    // Breathe fills the strip with the color dimmed per the dimming map
+    case MODE_BREATHE: {
+      if(_hwDimming) return _color;  // LEDs do the dimming themselves
+      CRGB c = _color;  // Use the base color
+      c %= _breatheLevel();
+      return c;
+    }
+
+    // Plane sweep -- brightness of each LED falls off with its distance from a
+    // plane moving along one axis
+    case MODE_PLANE:
+      return _band(_coord(_axis,i),(_tick * _sweepstep) & 0xFF);
+
+    // Radial pulse -- as with the plane sweep, but the band is a sphere whose
+    // radius grows each tick.  Distances come from the cache when it's current.
+    case MODE_RADIAL: {
+      byte r = (_ext != NULL && _ext->distCache != NULL && _ext->cacheOrigin == _origin) ? _ext->distCache[i] : _distance(i);
+      return _band(r,(_tick * _sweepstep) & 0xFF);
+    }
+
+    case MODE_NOISE: {
+      uint16_t t = (_tick * _sweepstep) & 0x7FFF;
+      // 16 bit products, as coordinate x scale can overflow an AVR int
+      byte hue = inoise8((uint16_t)_coord(AXIS_X,i)*_scale, (uint16_t)_coord(AXIS_Y,i)*_scale,
+                         (uint16_t)((uint16_t)_coord(AXIS_Z,i)*_scale + t));
+      return led_hue(hue);
+    }
+
+    case MODE_WAVE:
+      return _waveColor(_tick * _wave.step[0] + i * _wave.stride[0],
+                        _tick * _wave.step[1] + i * _wave.stride[1]);
+
+    case MODE_GRADIENT: {
+      CRGB c;
+      _drawGradient(&c,i,1);
+      return c;
+    }
+
+    // Animation frames build on each other, so can only be read back
+    case MODE_ANIM:
+      return _leds[i];
+
+    default:
+      return CRGB::Black;
+  }
+}
+
+// Color for an LED at distance pos along a spatial effect whose band is at band
+CRGB LEDControl::_band(byte pos, byte band)
+{
+  int d = abs((int)pos - (int)band);
+  if(d >= _bandwidth) return CRGB::Black;
+  CRGB c = _color;
+  c %= 255 - d*(256/_bandwidth);
+  return c;
+}
+
+// Which LED is lit by a run or Cylon at a given tick
+int LEDControl::_litPos(long tick)
+{
+  if(_mode == MODE_CYLON)  return _cylonPos(tick);
+  if(_mode == MODE_RUNREV) return _span-1-_phase(tick,_span);
+  return _phase(tick,_span);
+}
+
+// Position in the palette for LED i at tick _tick.  Palette cycles wrap round
+// at the end of the palette; rainbows at the end of the strip, so they move
+// one LED a tick and look the same on strips of any length.
+byte LEDControl::_paletteIndex(int i)
+{
+  if(_mode == MODE_PALETTE) return (uint32_t)i*_pal.stride + (uint32_t)_tick*_pal.step;
+  int p = _phase((_mode == MODE_RAINBF) ? i - _tick : i + _tick,_span);
+  return p*(256/_span);
+}
+
+CRGB LEDControl::_paletteColor(byte index)
+{
+  if(_mode != MODE_PALETTE || _pal.palette == NULL) return led_hue(index);
+  if(_pal.big) return ColorFromPalette(*(const CRGBPalette256 *)_pal.palette,index);
+  return ColorFromPalette(*(const CRGBPalette16 *)_pal.palette,index,255,LINEARBLEND);
+}
+
+// Color for an LED at phase a of the first wave and b of the second
+CRGB LEDControl::_waveColor(byte a, byte b)
+{
+  byte level = wave8(a);
+  if((_wave.stride[1] | _wave.step[1]) != 0) level = (level + wave8(b)) >> 1;
+  CRGB c = _color;
+  c %= _wave.floor + scale8(level,255 - _wave.floor);
+  return c;
+}
+
+// Brings the LEDs to the given frame of the animation, decoding on from the
+// frame already shown if possible and otherwise (or if restart is set, because
+// the LEDs have been drawn over) from the first frame
+void LEDControl::_playTo(unsigned int frame, boolean restart)
+{
+  if(restart || frame + 1 < _anim.frame) {
+    byte colors = pgm_read_byte(_anim.data+7);
+    _anim.next = _anim.data + LEDANIM_HEADER + 3*(colors ? colors : 256);
+    _anim.frame = 0;
+    fill_solid(_leds,_span,CRGB::Black);
+  }
+  while(_anim.frame <= frame) _decodeFrame();
+}
+
+// Decodes the next frame of the animation onto the LEDs, ignoring any LEDs past
+// the end of the strip (or sector)
+void LEDControl::_decodeFrame()
+{
+  const byte *p = _anim.next;
+  const byte *palette = _anim.data + LEDANIM_HEADER;
+  unsigned int leds = pgm_read_byte(_anim.data+3) | (pgm_read_byte(_anim.data+4) << 8);
+  unsigned int span = _span;
+  unsigned int i = 0;
+
+  while(i < leds) {
+    byte op = pgm_read_byte(p++);
+    unsigned int count = (op & 0x3F) + 1;
+    unsigned int end = min(i + count,span);
+
+    switch(op & 0xC0) {
+      case LEDANIM_RUN: {
+        const byte *c = palette + 3*pgm_read_byte(p++);
+        CRGB color(pgm_read_byte(c),pgm_read_byte(c+1),pgm_read_byte(c+2));
+        for(unsigned int j=i;j<end;j++) _leds[j] = color;
+        break;
+      }
+      case LEDANIM_LITERAL: {
+        const byte *q = p;
+        p += count;
+        for(unsigned int j=i;j<end;j++) {
+          const byte *c = palette + 3*pgm_read_byte(q++);
+          _leds[j] = CRGB(pgm_read_byte(c),pgm_read_byte(c+1),pgm_read_byte(c+2));
+        }
+        break;
+      }
+      // Skips leave the LEDs as they were
+    }
+    i += count;
+  }
+  _anim.next = p;
+  _anim.frame++;
+}
+
+// Marquee shifts the bitmap forward one LED each tick, rolling over within the
+// (at most 32) LEDs it covers
+unsigned long LEDControl::_marqueeBits()
+{
+  int m = min(_span,32);
+  int k = _phase(_tick,m);
+  unsigned long mask = (m == 32) ? 0xFFFFFFFFUL : ((1UL<<m)-1);
+  unsigned long bits = _bitmap & mask;
+  if(k != 0) bits = ((bits << k) | (bits >> (m-k))) & mask;
+  return bits;
+}
+
+// Breathe runs down the dimming map and back up again, showing the levels at
+// each end twice so the full cycle is 32 ticks.  At fractional speeds the
+// brightness is blended between this tick's level and the next.
+byte LEDControl::_breatheLevel()
+{
+  if(_mode != MODE_BREATHE) return 255;
+  byte level = _dimming[_breatheIndex(_tick)];
+  if(_speedFrac != 0) {
+    level = lerp8by8(level,_dimming[_breatheIndex(_tick+1)],_speedFrac);
+  }
+  return level;
+}
+
+// Lights LEDs in _color wherever there's a 1 in bits (limited to 32 LEDs)
+void LEDControl::_drawBitmap(unsigned long bits)
+{
+  fill_solid(_leds,_span,CRGB::Black);
+  int m = min(_span,32);
+  unsigned long mask = 1;  // Is unsigned long
+  for(int i=0;i<m;i++) {
+    if( (bits & (mask<<i)) != 0) { _leds[i] = _color; }
+  }
+}
+
+// Records that the LEDs have been redrawn, mirroring them first if need be
+void LEDControl::_changed()
+{
+  _changed(0,_span-1);
+}
+
+// Records that just LEDs first to last of the first sector have changed.  The
+// mirrored sectors are spread over the whole strip, so with symmetry the whole
+// strip counts as changed.
+void LEDControl::_changed(int first, int last)
+{
+  if(_sectors > 1) {
+    if(_leds != NULL) _reflect();
+    first = 0;
+    last = _ledCount-1;
+  }
+  _markDirty(first,last);
+}
+
+// Adds LEDs first to last to the ranges to be sent and previewed
+void LEDControl::_markDirty(int first, int last)
+{
+  _dirtyFirst = min(_dirtyFirst,first);
+  _dirtyLast = max(_dirtyLast,last);
+  if(_ext != NULL) {
+    _ext->previewFirst = min(_ext->previewFirst,first);
+    _ext->previewLast = max(_ext->previewLast,last);
+  }
+}
+
+// Position within an effect's cycle of period ticks, for any tick (even negative)
+int LEDControl::_phase(long tick, int period)
+{
+  long p = tick % period;
+  return (p < 0) ? p + period : p;
+}
+
+// Which LED the Cylon eye is on at a given tick
+int LEDControl::_cylonPos(long tick)
+{
+  int p = _phase(tick,2*_span);
+  return (p < _span) ? p : 2*_span-1-p;
+}
+
+// Which dimming level Breathe shows at a given tick
+int LEDControl::_breatheIndex(long tick)
+{
+  int p = _phase(tick,2*_numdims);
+  return (p < _numdims) ? p : 2*_numdims-1-p;
+}
+
+// Rotates the first _span LEDs by steps places, forward if positive.  Larger
+// rotations use the three reversal trick, which needs no extra memory.
+void LEDControl::_rotate(long steps)
+{
+  if(_leds == NULL) return;
+  int k = _phase(steps,_span);
+  if(k == 0) return;
+  if(k == 1)       { shiftFwd(); return; }
+  if(k == _span-1) { shiftRev(); return; }
+  _reverse(0,_span-1);
+  _reverse(0,k-1);
+  _reverse(k,_span-1);
+}
+
+void LEDControl::_reverse(int first, int last)
+{
+  while(first < last) {
+    CRGB t = _leds[first];
+    _leds[first++] = _leds[last];
+    _leds[last--] = t;
+  }
+}
+
+// Sets up a low resolution preview of the strip (e.g. for remote monitoring),
+// with each preview entry being the average of decimation LEDs.  Every interval
+// updates the preview is brought up to date and passed to callback.  The preview
+// array needs one entry per decimation LEDs, rounded up.  Pass a NULL preview to
+// turn previews off.  Needs extras (see setExtras()).
+void LEDControl::setPreview(CRGB preview[], byte decimation, byte interval, LEDPreviewCallback callback)
+{
+  LEDExtras *x = _ext;
+  if(x == NULL) return;
+  x->preview = preview;
+  x->previewDecimation = max(decimation,(byte)1);
+  x->previewInterval = max(interval,(byte)1);
+  x->previewCountdown = x->previewInterval;
+  x->previewCallback = callback;
+  x->previewFirst = 0;
+  x->previewLast = _ledCount-1;
+}
+
+// Recalculates only the preview entries covering LEDs changed since the last
+// preview, then hands the preview over
+void LEDControl::_updatePreview()
+{
+  LEDExtras *x = _ext;
+  int count = (_ledCount + x->previewDecimation - 1) / x->previewDecimation;
+  if(x->previewFirst <= x->previewLast) {
+    int firstBlock = x->previewFirst / x->previewDecimation;
+    int lastBlock = x->previewLast / x->previewDecimation;
+    for(int b=firstBlock;b<=lastBlock;b++) {
+      int start = b * x->previewDecimation;
+      int n = min((int)x->previewDecimation,_ledCount-start);
+      uint16_t r = 0, g = 0, bl = 0;
+      for(int i=start;i<start+n;i++) {
+        CRGB c = (_leds != NULL) ? _leds[i] : pixel(i);
+        r += c.r;
+        g += c.g;
+        bl += c.b;
+      }
+      x->preview[b] = CRGB(r/n,g/n,bl/n);
+    }
+    x->previewFirst = _ledCount;
+    x->previewLast = -1;
+  }
+  if(x->previewCallback != NULL) x->previewCallback(*this,x->preview,count);
+}
+
+// Reports the range of LEDs changed by update() since the last clearDirty(),
+// so output stages can skip re-sending LEDs that haven't changed.  Returns
+// false (leaving first & last alone) if nothing has changed.
+boolean LEDControl::getDirty(int &first, int &last)
+{
+  if(_dirtyFirst > _dirtyLast) return false;
+  first = _dirtyFirst;
+  last = _dirtyLast;
+  return true;
+}
+
+void LEDControl::clearDirty()
+{
+  _dirtyFirst = _ledCount;
+  _dirtyLast = -1;
+}
+
+void LEDControl::shiftFwd()
+{
+  if(_leds != NULL) led_shiftFwd<PixelRGB>(_leds,_span);
+}
+
+void LEDControl::shiftRev()
+{
+  if(_leds != NULL) led_shiftRev<PixelRGB>(_leds,_span);
+}
+
+// Position of an LED along one axis, or 0 if no coordinates were given for it
+byte LEDControl::_coord(int axis, int led)
+{
+  if(_ext == NULL || _ext->coords[axis] == NULL) return 0;
+  return pgm_read_byte(_ext->coords[axis] + led);
+}
+
+// Distance of an LED from the radial pulse origin.  Works
+// with half-unit offsets so the sum of squares fits in 16 bits, which also means
+// the result stays in the 0-220 range.
+byte LEDControl::_distance(int led)
+{
+  int dx = ((int)_coord(AXIS_X,led) - (int)(_origin & 0xFF)) / 2;
+  int dy = ((int)_coord(AXIS_Y,led) - (int)((_origin >> 8) & 0xFF)) / 2;
+  int dz = ((int)_coord(AXIS_Z,led) - (int)((_origin >> 16) & 0xFF)) / 2;
+  return sqrt16((uint16_t)(dx*dx) + (uint16_t)(dy*dy) + (uint16_t)(dz*dz));
+}
+
+// Fills the rest of the strip from the first sector.  With two sectors this is a
+// true reflection about the center, so odd length strips keep a single center LED.
+void LEDControl::_reflect()
+{
+  if(_sectors == 2) {
+    CRGB *src = _leds;
+    CRGB *dst = _leds + _ledCount - 1;
+    while(src < dst) { *dst-- = *src++; }
+    return;
+  }
+  for(int base=_span, j=1; base<_ledCount; base+=_span, j++) {
+    int n = min(_span,_ledCount-base);
+    CRGB *dst = _leds + base;
+    if(j & 1) {
+      const CRGB *src = _leds + _span - 1;
+      for(int k=0;k<n;k++) { *dst++ = *src--; }
+    }
+    else {
+      memcpy(dst,_leds,n*sizeof(CRGB));
+    }
+  }
+}
+
+LEDBatch *LEDBatch::_pending = NULL;
+
+LEDBatch::LEDBatch()
+{
+  _count = 0;
+  _next = NULL;
+}
+
+// A committed batch that goes away before the next updateAll() is dropped,
+// rather than left for updateAll() to read
+LEDBatch::~LEDBatch()
+{
+  for(LEDBatch **b=&_pending;*b!=NULL;b=&(*b)->_next) {
+    if(*b == this) {
+      *b = _next;
+      break;
+    }
+  }
+}
+
+// Adds a mode change for a strip to the batch (see LEDControl::setMode() for
+// what the arguments mean).  Returns false if the batch is full.
+boolean LEDBatch::add(LEDControl &strip, byte mode, CRGB color, unsigned long param)
+{
+  if(_count == LED_BATCH_SIZE) return false;
+  Change &c = _changes[_count++];
+  c.strip = &strip;
+  c.mode = mode;
+  c.color = color;
+  c.param = param;
+  return true;
+}
+
+void LEDBatch::clear()
+{
+  _count = 0;
+}
+
+// Makes all the changes right away.  Every strip starts its new effect on its
+// next update, so strips updated together stay in step.
+void LEDBatch::apply()
+{
+  for(int i=0;i<_count;i++) {
+    _changes[i].strip->setMode(_changes[i].mode,_changes[i].color,_changes[i].param);
+  }
+}
+
+// Has LEDControl::updateAll() make all the changes just before it next updates
+// the strips, so they all take effect on the same tick however the strips are
+// updated in between.  The batch must stay unchanged until then.  Batches
+// committed before the same updateAll() all take effect on that tick, in the
+// order they were committed; committing a batch that's already waiting does
+// nothing.
+void LEDBatch::commit()
+{
+  LEDBatch **b;
+  for(b=&_pending;*b!=NULL;b=&(*b)->_next) {
+    if(*b == this) return;
+  }
+  _next = NULL;
+  *b = this;
+}
+
+// Makes the changes in every committed batch; called by LEDControl::updateAll()
+void LEDBatch::applyPending()
 {
-  CRGB first = _leds[0];
-  for(int i=0;i<_ledCount-1;i++) {
-    _leds[i] = _leds[i+1];
+  LEDBatch *batch = _pending;
+  _pending = NULL;
+  while(batch != NULL) {
+    LEDBatch *next = batch->_next;
+    batch->_next = NULL;
+    batch->apply();
+    batch = next;
   }
-  _leds[_ledCount-1] = first;
 }
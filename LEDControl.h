@@ -13,14 +13,125 @@
 #define MODE_BITMAP 8
 #define MODE_MARQUEE	9
 #define MODE_BREATHE	10
-#define NUM_MODES   11
+#define MODE_PLANE	11
+#define MODE_RADIAL	12
+#define MODE_NOISE	13
+#define MODE_ANIM	14
+#define MODE_PALETTE	15
+#define MODE_WAVE	16
+#define MODE_GRADIENT	17
+#define NUM_MODES   18
+
+// Axes for spatial effects on strips with 3D coordinates
+#define AXIS_X  0
+#define AXIS_Y  1
+#define AXIS_Z  2
+
+// Most notification overlays that can be stacked on a strip at once.  Sizes
+// like this have to be changed here rather than in a sketch, as the library is
+// compiled separately and has to agree with sketches on the size of LEDControl.
+#define LED_MAX_OVERLAYS  3
+
+// Most mode changes a LEDBatch can hold
+#define LED_BATCH_SIZE  16
+
+// Most strips the registry (see updateAll()) keeps track of
+#define LED_MAX_STRIPS  16
+
+// LEDs renderPixels() works out at a time, in a CRGB buffer on the stack
+#define LED_RENDER_CHUNK  8
 
 #include "Arduino.h"
+#include "LEDEase.h"
+#include "LEDAnim.h"
+#include "LEDPixel.h"
+
+class LEDControl;
+typedef void (*LEDPreviewCallback)(LEDControl &strip, const CRGB preview[], int count);
+typedef void (*LEDTileCallback)(LEDControl &strip, const CRGB tile[], int first, int count, void *context);
+
+// A notification temporarily covering a strip (see pushOverlay())
+struct LEDOverlay
+{
+  unsigned int ticksLeft;  // 0 means until removed
+  byte priority;
+  CRGB color;
+  byte onTicks;            // Blink cadence (offTicks 0 means no blinking)
+  byte offTicks;
+  byte blink;              // Position in the blink cycle
+};
+
+// Saved animation state (see saveState())
+#define LED_STATE_VERSION  2
+#define LED_STATE_SIZE     20
+
+// Settings that can be changed smoothly over time (see tweenColor(), etc)
+#define TWEEN_NONE      0
+#define TWEEN_COLOR     1
+#define TWEEN_PROGRESS  2
+#define TWEEN_SPEED     3
+#define TWEEN_STOP      4
+
+// A transition of one setting from one value to another
+struct LEDTween
+{
+  int32_t from;
+  int32_t to;
+  unsigned int duration;
+  unsigned int elapsed;
+  byte target;   // Which setting (TWEEN_NONE when idle)
+  byte curve;    // Easing curve, see LEDEase.h
+};
+
+// State for a strip's optional features: overlays, transitions (including the
+// progress bar's), previews, the watchdog and fault count, snapshot saving and
+// the coordinate, distance and frame caches.  Strips just hold a
+// pointer to one, given with setExtras(), so the many strips that don't use
+// these features don't carry room for them.  Only LEDControl uses the fields.
+struct LEDExtras
+{
+  const byte *coords[3];   // Per-axis LED positions (PROGMEM), or NULL
+  byte *distCache;         // Optional per-LED distance from the effect origin
+  CRGB *preview;           // Low resolution copy of the strip, or NULL
+  CRGB *frames;            // Optional cache of one whole cycle of the effect
+  LEDPreviewCallback previewCallback;
+  uint32_t cacheOrigin;    // Origin the distance cache was built for
+  uint32_t lastUpdate;     // When (millis()) update() was last called
+  uint32_t lastSave;       // When (millis()) the settings were saved
+  LEDTween tween;
+  int previewFirst;        // Range of LEDs changed since the last preview
+  int previewLast;
+  int framesSize;          // LEDs the frame cache has room for
+  unsigned int tickMillis; // Expected time between updates (0 if not watched)
+  unsigned int budget;     // Most time (micros()) an update should take, or 0
+  unsigned int missed;     // Ticks caught up after update() wasn't called
+  unsigned int overlayShown;  // Which overlay state is on the LEDs (0 for none)
+  unsigned int savedSum;   // Checksum of the settings last saved
+  LEDOverlay overlays[LED_MAX_OVERLAYS];  // In priority order, highest last
+  byte numOverlays;
+  byte previewDecimation;  // LEDs averaged into each preview entry
+  byte previewInterval;    // Updates between previews
+  byte previewCountdown;
+  byte percent;            // Progress bar percentage
+  byte faults;             // Times the strip's state was found corrupt
+  boolean framesValid;     // Frame cache holds the current effect
+  boolean degraded;        // Skipping optional work as updates are over budget
+};
+
 class LEDControl
 {
   public:
     LEDControl(int num_leds, CRGB leds[]);
+    ~LEDControl();
+    static void updateAll();
+    static void showAll();
+    static int stripCount();
+    static LEDControl *getStrip(int i);
+    static unsigned long globalTick();
+    static void setGlobalTick(unsigned long tick);
     int getMode();
+    boolean setMode(byte mode, CRGB color, unsigned long param = 0);
+    void setOff();
     void setOneColor(CRGB color);
     void setRunFwd(CRGB color);
     void setRunRev(CRGB color);
@@ -29,20 +140,203 @@ class LEDControl
     void setRainbowRev();
     void setPattern(CRGB color, unsigned long bitmap);
     void setProgress(CRGB color, int percent);
+    void setProgress(CRGB color, int percent, unsigned int ticks, byte curve = EASE_INOUT_QUAD);
     void setMarquee(CRGB color, unsigned long bitmap);
     void setBreathe(CRGB color);
+    void setCoordinates(const byte xs[], const byte ys[], const byte zs[]);
+    void setDistanceCache(byte cache[]);
+    void setFrameCache(CRGB cache[], int size);
+    void setPlaneSweep(CRGB color, int axis);
+    void setRadialPulse(CRGB color, byte x, byte y, byte z);
+    void setNoise(byte scale);
+    boolean setAnimation(const byte data[]);
+    void setPaletteCycle(const CRGBPalette16 &palette, byte stride, int step);
+    void setPaletteCycle(const CRGBPalette256 &palette, byte stride, int step);
+    void setHueCycle(byte stride, int step);
+    void setWave(CRGB color, byte stride, int step, byte floor = 0);
+    void addWave(byte stride, int step);
+    void setGradient(CRGB from, CRGB to);
+    void setGradient(CRGB stops[], byte count);
+    void setSymmetry(byte sectors);
+    void setExtras(LEDExtras *extras);
+    void setHardwareDimming(boolean enable);
+    byte getDimming();
     void shiftFwd();
     void shiftRev();
     void update();
+    void setWatchdog(unsigned int tickMillis, unsigned int budgetMicros);
+    boolean isStalled();
+    boolean isDegraded();
+    byte getFaults();
+    unsigned int getMissedTicks();
+    void setSpeed(int speed);
+    int getSpeed();
+    void pause();
+    void resume();
+    boolean isPaused();
+    void step(int ticks = 1);
+    void seek(long tick);
+    long getTick();
+    void setPhaseOrigin(unsigned long origin);
+    void alignTo(LEDControl &other);
+    CRGB pixel(int i);
+    void render(CRGB chunk[], int first, int count);
+    template<class P> void renderPixels(typename P::pixel_t pixels[], int first, int count);
+    void renderTiles(CRGB scratch[], int tileSize, byte halo, LEDTileCallback sink, void *context);
+    void tweenColor(CRGB color, unsigned int ticks, byte curve = EASE_INOUT_QUAD);
+    void tweenSpeed(int speed, unsigned int ticks, byte curve = EASE_INOUT_QUAD);
+    void tweenStop(byte stop, CRGB color, unsigned int ticks, byte curve = EASE_INOUT_QUAD);
+    int saveState(byte state[]);
+    boolean restoreState(const byte state[]);
+    boolean needsSave(unsigned long minInterval);
+    boolean pushOverlay(byte priority, CRGB color, unsigned int duration = 0, byte onTicks = 1, byte offTicks = 0);
+    void popOverlay(byte priority);
+    void clearOverlays();
+    boolean hasOverlay();
+    boolean getDirty(int &first, int &last);
+    void clearDirty();
+    void setPreview(CRGB preview[], byte decimation, byte interval, LEDPreviewCallback callback);
   private:
-    int _ledCount;
+    static LEDControl *_strips[LED_MAX_STRIPS];
+    static byte _numStrips;
+    static unsigned long _globalTick;  // Calls to updateAll() so far
+    // Fields are grouped by size, largest first, so there's no padding between
+    // them on 32/64-bit hosts; on AVR everything packs regardless.
     CRGB *_leds;
-    boolean _newMode;
-    int _mode;
+    LEDExtras *_ext;         // Optional features' state, or NULL
+    union {                  // Mode specific settings
+      uint32_t _bitmap;      // Pattern & Marquee: which LEDs are lit (limited to 32 leds)
+      uint32_t _origin;      // Radial Pulse: center point, packed as z:y:x
+      byte _axis;            // Plane Sweep: axis to sweep along
+      byte _scale;           // Noise: how finely to sample the noise
+      struct {               // Animation: data, and how far decoding has got
+        const byte *data;
+        const byte *next;    // Where the next frame to decode starts
+        uint16_t frame;      // Number of that frame
+      } _anim;
+      struct {               // Palette Cycle
+        const void *palette; // CRGBPalette16 or 256, or NULL for the hue wheel
+        byte stride;         // Palette steps from one LED to the next
+        byte step;           // Palette steps moved each tick (mod 256)
+        boolean big;         // palette is a CRGBPalette256
+      } _pal;
+      struct {               // Wave: up to two waves, added together
+        byte stride[2];      // Phase difference from one LED to the next
+        byte step[2];        // Phase moved each tick (mod 256)
+        byte floor;          // Lowest brightness
+      } _wave;
+      struct {               // Gradient: stops spread evenly along the strip
+        CRGB *stops;         // Caller's stops, or NULL for _color to end
+        byte count;
+        CRGB end;            // Last color of a two color gradient
+      } _grad;
+    };
+    int32_t _tick;           // Ticks the current effect has run
+    int _ledCount;
+    int _span;               // LEDs actually rendered, i.e. the length of one sector
+    int _speed;              // Ticks per update, in 1/256ths (negative runs backwards)
+    int _dirtyFirst;         // Range of LEDs changed since the last clearDirty()
+    int _dirtyLast;
     CRGB _color;
-    int _curdir;  // Used to keep track of direction in bi-directional runs
-    unsigned long _bitmap;  // limited to 32 leds
-    int _config;
+    byte _mode;
+    byte _sectors;           // Number of mirrored sectors (1 means no symmetry)
+    byte _speedFrac;         // Fraction of a tick carried over to the next update
+    byte _level;             // Current Breathe brightness
+    boolean _newMode : 1;
+    boolean _paused : 1;
+    boolean _hwDimming : 1;  // Breathe via the LEDs' own brightness control
+    void _startMode(byte mode);
+    boolean _covered();
+    void _dropFrames();
+    boolean _checkState();
+    void _recover();
+    void _catchUp();
+    void _render();
+    void _draw();
+    int _cachePeriod();
+    int _stepPeriod(byte step);
+    void _fillCache(int period);
+    void _advance(long steps);
+    void _changed();
+    void _changed(int first, int last);
+    void _markDirty(int first, int last);
+    long _ticksThisUpdate();
+    void _updateOverlays();
+    void _drawOverlay();
+    void _removeOverlay(int i);
+    void _startTween(byte target, long from, long to, unsigned int ticks, byte curve);
+    void _stepTween(LEDTween &tween);
+    unsigned long _progressBits(int percent);
+    void _packState(byte state[]);
+    void _saved(const byte state[]);
+    unsigned int _stateSum(const byte state[]);
+    void _drawBitmap(unsigned long bits);
+    CRGB _pixelAt(int i);
+    CRGB _band(byte pos, byte band);
+    int _litPos(long tick);
+    unsigned long _marqueeBits();
+    byte _breatheLevel();
+    byte _paletteIndex(int i);
+    CRGB _paletteColor(byte index);
+    CRGB _waveColor(byte a, byte b);
+    CRGB &_gradStop(byte k);
+    int _gradPos(byte k);
+    void _drawGradient(CRGB out[], int first, int count);
+    void _playTo(unsigned int frame, boolean restart);
+    void _decodeFrame();
+    void _rotate(long steps);
+    void _reverse(int first, int last);
+    int _phase(long tick, int period);
+    int _cylonPos(long tick);
+    int _breatheIndex(long tick);
+    void _reflect();
+    void _updatePreview();
+    byte _distance(int led);
+    byte _coord(int axis, int led);
+};
+
+// Works out count LEDs starting with LED first, as render() does, but into
+// pixels of the type given by a pixel policy (see LEDPixel.h), e.g.
+// renderPixels<PixelMono8>() for a single color PWM array with one byte per
+// LED.  Colors go through a few CRGBs at a time, so a strip made without an
+// LED array needs no CRGB buffer at all, only the pixels themselves.
+template<class P>
+void LEDControl::renderPixels(typename P::pixel_t pixels[], int first, int count)
+{
+  CRGB chunk[LED_RENDER_CHUNK];
+  while(count > 0) {
+    int n = (count < LED_RENDER_CHUNK) ? count : LED_RENDER_CHUNK;
+    render(chunk,first,n);
+    led_convert<P>(chunk,pixels,n);
+    pixels += n;
+    first += n;
+    count -= n;
+  }
+}
+
+// A set of mode changes for several strips, applied together so the strips
+// start their new effects in step (see commit())
+class LEDBatch
+{
+  public:
+    LEDBatch();
+    ~LEDBatch();
+    boolean add(LEDControl &strip, byte mode, CRGB color, unsigned long param = 0);
+    void clear();
+    void apply();
+    void commit();
+    static void applyPending();
+  private:
+    struct Change {
+      LEDControl *strip;
+      uint32_t param;
+      CRGB color;
+      byte mode;
+    };
+    Change _changes[LED_BATCH_SIZE];
+    LEDBatch *_next;            // Next batch committed after this one
+    byte _count;
+    static LEDBatch *_pending;  // Batches to apply at the next updateAll(), in order
 };
 
 #endif
@@ -0,0 +1,76 @@
+/*
+ * LED Ease -- easing curve tables.  See LEDEase.h
+ *
+ * Author: David Bryant <david@orangemoose.com>
+ */
+
+#include "Arduino.h"
+#include "LEDEase.h"
+
+// Curve formulas, for t from 0 to 1
+constexpr double inQuad(double t)    { return t*t; }
+constexpr double inCubic(double t)   { return t*t*t; }
+constexpr double outQuad(double t)   { return 1 - inQuad(1-t); }
+constexpr double outCubic(double t)  { return 1 - inCubic(1-t); }
+constexpr double inOutQuad(double t) { return t < 0.5 ? 2*t*t : 1 - 2*(1-t)*(1-t); }
+constexpr double inOutCubic(double t){ return t < 0.5 ? 4*t*t*t : 1 - 4*(1-t)*(1-t)*(1-t); }
+
+// The usual "bounce" ease out -- four parabolic bounces, each a quarter the height
+// of the one before
+constexpr double bounce(double t)
+{
+  return t < 1/2.75   ? 7.5625*t*t :
+         t < 2/2.75   ? 7.5625*(t-1.5/2.75)*(t-1.5/2.75) + 0.75 :
+         t < 2.5/2.75 ? 7.5625*(t-2.25/2.75)*(t-2.25/2.75) + 0.9375 :
+                        7.5625*(t-2.625/2.75)*(t-2.625/2.75) + 0.984375;
+}
+
+// One cycle of a sine wave, running from 0.5 up to 1, down to 0 and back.  The
+// sine is worked out from its Taylor series (up to x^15, plenty for 8 bits) as
+// the standard library's sin() isn't constexpr.  Entries are spaced 1/256th of
+// a cycle apart, so t (which runs to 1 over 255 entries) is scaled to suit.
+constexpr double taylorSin(double x, double x2)
+{
+  return x*(1 - x2/6*(1 - x2/20*(1 - x2/42*(1 - x2/72*(1 - x2/110*(1 - x2/156*(1 - x2/210)))))));
+}
+constexpr double twoPi = 6.283185307179586;
+constexpr double cycleSin(double c)  { return taylorSin(twoPi*c,twoPi*c*twoPi*c); }
+constexpr double sine(double t)
+{
+  return 0.5 + 0.5*cycleSin(t*255/256 < 0.5 ? t*255/256 : t*255/256 - 1);
+}
+
+// Table entry i of a curve, scaled and rounded to 0-255
+#define EASE(f,i)  ((byte)(f((i)/255.0)*255 + 0.5))
+#define EASE4(f,i)   EASE(f,i), EASE(f,i+1), EASE(f,i+2), EASE(f,i+3)
+#define EASE16(f,i)  EASE4(f,i), EASE4(f,i+4), EASE4(f,i+8), EASE4(f,i+12)
+#define EASE64(f,i)  EASE16(f,i), EASE16(f,i+16), EASE16(f,i+32), EASE16(f,i+48)
+#define EASE256(f)   { EASE64(f,0), EASE64(f,64), EASE64(f,128), EASE64(f,192) }
+
+const static byte _inQuad[256] PROGMEM = EASE256(inQuad);
+const static byte _outQuad[256] PROGMEM = EASE256(outQuad);
+const static byte _inOutQuad[256] PROGMEM = EASE256(inOutQuad);
+const static byte _inCubic[256] PROGMEM = EASE256(inCubic);
+const static byte _outCubic[256] PROGMEM = EASE256(outCubic);
+const static byte _inOutCubic[256] PROGMEM = EASE256(inOutCubic);
+const static byte _bounce[256] PROGMEM = EASE256(bounce);
+const static byte _sine[256] PROGMEM = EASE256(sine);
+
+const static byte * const _curves[NUM_EASES] = {
+  NULL, _inQuad, _outQuad, _inOutQuad, _inCubic, _outCubic, _inOutCubic, _bounce
+};
+
+// How far (0-255) a value following the given curve has moved, x/255ths of the
+// way through its transition.  Unknown curves are treated as linear.
+byte ease8(byte curve, byte x)
+{
+  if(curve >= NUM_EASES || _curves[curve] == NULL) return x;
+  return pgm_read_byte(_curves[curve] + x);
+}
+
+// Sine wave at phase (0-255 for a full cycle), scaled to 0-255 with 128 at
+// phase 0, for wave effects
+byte wave8(byte phase)
+{
+  return pgm_read_byte(_sine + phase);
+}
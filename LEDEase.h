@@ -0,0 +1,33 @@
+/*
+ * LED Ease -- easing curves for animating LED Control settings smoothly
+ * from one value to another.
+ *
+ * Each curve is a 256 entry table, mapping how far through a transition we
+ * are (0-255) to how far the value has moved (0-255).  The tables are
+ * generated at compile time from the curve formulas and live in PROGMEM, so
+ * they cost no RAM and are shared by every strip.  A sine table for the wave
+ * effects is made the same way.
+ *
+ * Author: David Bryant <david@orangemoose.com>
+ */
+
+#ifndef LEDEase_h
+#define LEDEase_h
+
+#include "Arduino.h"
+
+// Easing curves
+#define EASE_LINEAR       0
+#define EASE_IN_QUAD      1
+#define EASE_OUT_QUAD     2
+#define EASE_INOUT_QUAD   3
+#define EASE_IN_CUBIC     4
+#define EASE_OUT_CUBIC    5
+#define EASE_INOUT_CUBIC  6
+#define EASE_BOUNCE       7
+#define NUM_EASES         8
+
+byte ease8(byte curve, byte x);
+byte wave8(byte phase);
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * LED Frame Map -- memory mapped LED arrays for Linux.  See LEDFrameMap.h
+ *
+ * Author: David Bryant <david@orangemoose.com>
+ */
+
+#if defined(__linux__)
+
+#include "Arduino.h"
+#include <FastLED.h>
+#include "LEDFrameMap.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define HUGE_PAGE (2UL*1024*1024)
+
+LEDFrameMap::LEDFrameMap()
+{
+  _map = NULL;
+  _pixels = 0;
+  _mapSize = 0;
+}
+
+LEDFrameMap::~LEDFrameMap()
+{
+  close();
+}
+
+// Maps room for the given number of pixels.  With a path the pixels live in
+// that file (created if need be), which other processes can map too; a file on
+// a hugetlbfs mount gets huge pages.  With a NULL path the memory is private to
+// this process, using huge pages if the system has any reserved and otherwise
+// asking for transparent huge pages.  Either way strips laid out one after the
+// other in the mapping are updated with purely sequential memory access.
+boolean LEDFrameMap::open(const char *path, long pixels)
+{
+  close();
+  size_t size = (pixels * sizeof(CRGB) + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+  void *map = MAP_FAILED;
+
+  if(path != NULL) {
+    int fd = ::open(path,O_RDWR | O_CREAT,0664);
+    if(fd < 0) return false;
+    if(ftruncate(fd,size) == 0) {
+      map = mmap(NULL,size,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+    }
+    ::close(fd);
+  }
+  else {
+    map = mmap(NULL,size,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,-1,0);
+    if(map == MAP_FAILED) {
+      map = mmap(NULL,size,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+    }
+  }
+  if(map == MAP_FAILED) return false;
+
+#ifdef MADV_HUGEPAGE
+  madvise(map,size,MADV_HUGEPAGE);
+#endif
+  _map = (CRGB *)map;
+  _pixels = pixels;
+  _mapSize = size;
+  return true;
+}
+
+void LEDFrameMap::close()
+{
+  if(_map != NULL) munmap(_map,_mapSize);
+  _map = NULL;
+  _pixels = 0;
+}
+
+// LED array for a strip whose LEDs start at pixel first of the mapping, to be
+// passed to the LEDControl (and FastLED) constructors
+CRGB *LEDFrameMap::leds(long first)
+{
+  return _map + first;
+}
+
+long LEDFrameMap::size()
+{
+  return _pixels;
+}
+
+// Flushes a file backed mapping out to the file, e.g. before a recorder reads
+// the file directly rather than mapping it.  Not needed for other processes
+// that map the same file, as they share the same memory.
+boolean LEDFrameMap::sync()
+{
+  return msync(_map,_mapSize,MS_SYNC) == 0;
+}
+
+#endif
@@ -0,0 +1,35 @@
+/*
+ * LED Frame Map -- keeps the LED arrays for many strips in one contiguous
+ * memory mapping on Linux, for very large installations.  Each strip's LED
+ * array is a view into the mapping, so other processes (compositors,
+ * recorders) can map the same file and see every strip's frame without any
+ * copying.
+ *
+ * Author: David Bryant <david@orangemoose.com>
+ */
+
+#ifndef LEDFrameMap_h
+#define LEDFrameMap_h
+
+#if defined(__linux__)
+
+#include "Arduino.h"
+
+class LEDFrameMap
+{
+  public:
+    LEDFrameMap();
+    ~LEDFrameMap();
+    boolean open(const char *path, long pixels);
+    void close();
+    CRGB *leds(long first);
+    long size();
+    boolean sync();
+  private:
+    CRGB *_map;
+    long _pixels;
+    size_t _mapSize;
+};
+
+#endif
+#endif
@@ -0,0 +1,289 @@
+/*
+ * LED Output -- output stages for LED Control.  See LEDOutput.h
+ *
+ * Author: David Bryant <david@orangemoose.com>
+ */
+
+#include "Arduino.h"
+#include <FastLED.h>
+#include "LEDControl.h"
+#include "LEDPixel.h"
+#include "LEDOutput.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+#endif
+
+// Waveform for every possible color byte, at 3x and 4x oversampling.  At 3x a 0
+// bit is sent as 100 and a 1 as 110; at 4x as 1000 and 1110.  Both tables are
+// in RAM (768 and 1024 bytes) in any sketch using an encoder; each is filled in
+// the first time an encoder with that oversampling is made.
+static byte _ws3[256][3];
+static byte _ws4[256][4];
+static boolean _ws3built = false;
+static boolean _ws4built = false;
+
+// LEDs generated at a time when streaming from a strip
+#define STREAM_CHUNK  8
+
+static void buildTable(byte oversample)
+{
+  for(int v=0;v<256;v++) {
+    unsigned long bits = 0;
+    for(int b=7;b>=0;b--) {
+      if(oversample == 3) bits = (bits << 3) | ((v & (1<<b)) ? 0x6 : 0x4);
+      else                bits = (bits << 4) | ((v & (1<<b)) ? 0xE : 0x8);
+    }
+    for(int i=0;i<oversample;i++) {
+      byte out = bits >> (8*(oversample-1-i));
+      if(oversample == 3) _ws3[v][i] = out;
+      else                _ws4[v][i] = out;
+    }
+  }
+  if(oversample == 3) _ws3built = true;
+  else                _ws4built = true;
+}
+
+// Oversampling is 3 or 4 (anything else is treated as 4), and the order is one of
+// FastLED's EOrder values (RGB, GRB, ...).  For RGBW strips the white component
+// is pulled out of each color and sent as a fourth byte.
+WS2812Encoder::WS2812Encoder(byte oversample, EOrder order, boolean rgbw)
+{
+  _oversample = (oversample == 3) ? 3 : 4;
+  _channels = rgbw ? 4 : 3;
+  _order[0] = (order >> 6) & 0x3;
+  _order[1] = (order >> 3) & 0x3;
+  _order[2] = order & 0x3;
+
+  if(_oversample == 3 && !_ws3built) buildTable(3);
+  if(_oversample == 4 && !_ws4built) buildTable(4);
+}
+
+// Bytes of SPI data needed for count LEDs (not including the reset gap)
+size_t WS2812Encoder::frameSize(int count)
+{
+  return (size_t)count * _channels * _oversample;
+}
+
+// Encodes LEDs first through last into their place in buffer, which must be at
+// least frameSize() bytes for the whole strip.  The rest of the buffer is left
+// alone, so a DMA buffer can be updated in place.
+void WS2812Encoder::encode(const CRGB leds[], int first, int last, byte buffer[])
+{
+  byte *out = buffer + (size_t)first * _channels * _oversample;
+  const byte c0 = _order[0], c1 = _order[1], c2 = _order[2];
+
+  if(_oversample == 3) {
+    for(int i=first;i<=last;i++) {
+      CRGB c = leds[i];
+      byte w = 0;
+      if(_channels == 4) {
+        CRGBW p = PixelRGBW::from(c);
+        c = CRGB(p.r,p.g,p.b);
+        w = p.w;
+      }
+      memcpy(out,_ws3[c.raw[c0]],3); out += 3;
+      memcpy(out,_ws3[c.raw[c1]],3); out += 3;
+      memcpy(out,_ws3[c.raw[c2]],3); out += 3;
+      if(_channels == 4) { memcpy(out,_ws3[w],3); out += 3; }
+    }
+  }
+  else {
+    for(int i=first;i<=last;i++) {
+      CRGB c = leds[i];
+      byte w = 0;
+      if(_channels == 4) {
+        CRGBW p = PixelRGBW::from(c);
+        c = CRGB(p.r,p.g,p.b);
+        w = p.w;
+      }
+      memcpy(out,_ws4[c.raw[c0]],4); out += 4;
+      memcpy(out,_ws4[c.raw[c1]],4); out += 4;
+      memcpy(out,_ws4[c.raw[c2]],4); out += 4;
+      if(_channels == 4) { memcpy(out,_ws4[w],4); out += 4; }
+    }
+  }
+}
+
+// Incremental version -- encodes only the LEDs the strip reports as changed and
+// then clears its dirty range.  Returns false if there was nothing to encode.
+boolean WS2812Encoder::encode(LEDControl &strip, const CRGB leds[], byte buffer[])
+{
+  int first, last;
+  if(!strip.getDirty(first,last)) return false;
+  encode(leds,first,last,buffer);
+  strip.clearDirty();
+  return true;
+}
+
+// Encodes count LEDs starting with LED first into out (which needs
+// frameSize(count) bytes), having the strip generate them a few at a time (see
+// LEDControl::render()) rather than reading them from an LED array.  Lets a
+// strip without an LED array be sent out in small pieces.
+void WS2812Encoder::stream(LEDControl &strip, int first, int count, byte out[])
+{
+  CRGB chunk[STREAM_CHUNK];
+  while(count > 0) {
+    int n = min(count,STREAM_CHUNK);
+    strip.render(chunk,first,n);
+    encode(chunk,0,n-1,out);
+    out += frameSize(n);
+    first += n;
+    count -= n;
+  }
+}
+
+// APA102 LEDs expect blue, green, red (BGR) unless the strip says otherwise
+APA102Frame::APA102Frame(EOrder order)
+{
+  _order[0] = (order >> 6) & 0x3;
+  _order[1] = (order >> 3) & 0x3;
+  _order[2] = order & 0x3;
+  _brightness = 31;
+}
+
+// Start frame, 4 bytes per LED, then an end frame of at least one clock edge per
+// two LEDs (data is delayed half a clock at each LED).  The end frame is always
+// at least 4 bytes, which SK9822 LEDs need to latch the new colors.
+size_t APA102Frame::frameSize(int count)
+{
+  size_t end = (count + 15) / 16;
+  if(end < 4) end = 4;
+  return 4 + (size_t)count * 4 + end;
+}
+
+// Writes the whole frame, with every LED at the given brightness (0-31)
+void APA102Frame::build(const CRGB leds[], int count, byte brightness, byte frame[])
+{
+  memset(frame,0x00,4);
+  memset(frame + 4 + count*4,0xFF,frameSize(count) - 4 - count*4);
+  _brightness = brightness & 0x1F;
+  setBrightness(count,_brightness,frame);
+  setColors(leds,0,count-1,frame);
+}
+
+// Rewrites just the colors of LEDs first through last
+void APA102Frame::setColors(const CRGB leds[], int first, int last, byte frame[])
+{
+  byte *out = frame + 4 + first*4 + 1;
+  const byte c0 = _order[0], c1 = _order[1], c2 = _order[2];
+  for(int i=first;i<=last;i++) {
+    out[0] = leds[i].raw[c0];
+    out[1] = leds[i].raw[c1];
+    out[2] = leds[i].raw[c2];
+    out += 4;
+  }
+}
+
+// Rewrites just the LED headers, i.e. the 5-bit brightness of every LED
+void APA102Frame::setBrightness(int count, byte brightness, byte frame[])
+{
+  byte header = 0xE0 | (brightness & 0x1F);
+  byte *out = frame + 4;
+  for(int i=0;i<count;i++) {
+    *out = header;
+    out += 4;
+  }
+}
+
+// 5-bit brightness for a strip's current dimming
+static byte stripBrightness(LEDControl &strip)
+{
+  byte brightness = ((unsigned int)strip.getDimming() * 31 + 127) / 255;
+  if(brightness == 0) brightness = 1;  // Keep the LEDs lit, as Breathe does
+  return brightness;
+}
+
+// Incremental version for a strip -- rewrites only the colors that changed since
+// the last call, plus the brightness field when the strip's dimming has changed
+// (see LEDControl::setHardwareDimming()).  The frame needs to have been
+// initialized with the full build() first.  Returns false if nothing changed.
+boolean APA102Frame::build(LEDControl &strip, const CRGB leds[], int count, byte frame[])
+{
+  boolean changed = false;
+  int first, last;
+  if(strip.getDirty(first,last)) {
+    setColors(leds,first,last,frame);
+    strip.clearDirty();
+    changed = true;
+  }
+  byte brightness = stripBrightness(strip);
+  if(brightness != _brightness) {
+    setBrightness(count,brightness,frame);
+    _brightness = brightness;
+    changed = true;
+  }
+  return changed;
+}
+
+// Writes the 4 byte frames for count LEDs starting with LED first into out
+// (count*4 bytes), having the strip generate them (see LEDControl::render())
+// rather than reading them from an LED array.  Brightness comes from the
+// strip's dimming.  The start frame (4 zero bytes) and end frame (the rest of
+// frameSize(), all 0xFF) are up to the caller.
+void APA102Frame::stream(LEDControl &strip, int first, int count, byte out[])
+{
+  CRGB chunk[STREAM_CHUNK];
+  const byte header = 0xE0 | stripBrightness(strip);
+  const byte c0 = _order[0], c1 = _order[1], c2 = _order[2];
+  while(count > 0) {
+    int n = min(count,STREAM_CHUNK);
+    strip.render(chunk,first,n);
+    for(int i=0;i<n;i++) {
+      out[0] = header;
+      out[1] = chunk[i].raw[c0];
+      out[2] = chunk[i].raw[c1];
+      out[3] = chunk[i].raw[c2];
+      out += 4;
+    }
+    first += n;
+    count -= n;
+  }
+}
+
+#if defined(__linux__)
+LEDFdSink::LEDFdSink(int fd)
+{
+  _fd = fd;
+}
+
+// Opens and configures an SPI device (e.g. "/dev/spidev0.0") for sending LED
+// data at the given clock speed.  Returns the file descriptor, or -1 on error.
+int LEDFdSink::openSpi(const char *device, unsigned long speed)
+{
+  int fd = open(device,O_WRONLY);
+  if(fd < 0) return -1;
+
+  uint8_t mode = SPI_MODE_0;
+  uint8_t bits = 8;
+  uint32_t hz = speed;
+  if(ioctl(fd,SPI_IOC_WR_MODE,&mode) < 0 ||
+     ioctl(fd,SPI_IOC_WR_BITS_PER_WORD,&bits) < 0 ||
+     ioctl(fd,SPI_IOC_WR_MAX_SPEED_HZ,&hz) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Writes the whole of data in one write(), which spidev sends as a single
+// transfer with no gaps.  Splitting a frame would leave the data line idle in
+// between, long enough for WS2812 LEDs to latch half a frame.  spidev refuses
+// transfers bigger than its bufsiz (4096 bytes by default), so longer frames
+// need it raised, e.g. with spidev.bufsiz=65536 on the kernel command line.
+// Files and pipes may take less at a time, so the rest is written after.
+// Returns false if the write fails.
+boolean LEDFdSink::write(const byte data[], size_t length)
+{
+  while(length > 0) {
+    ssize_t n = ::write(_fd,data,length);
+    if(n <= 0) return false;
+    data += n;
+    length -= n;
+  }
+  return true;
+}
+#endif
@@ -0,0 +1,70 @@
+/*
+ * LED Output -- output stages for LED Control, for boards that drive LEDs
+ * directly rather than through FastLED's own controllers (e.g. Linux single
+ * board computers clocking LEDs out over SPI).
+ *
+ * Author: David Bryant <david@orangemoose.com>
+ */
+
+#ifndef LEDOutput_h
+#define LEDOutput_h
+
+#include "Arduino.h"
+
+class LEDControl;
+
+// Encodes LED colors as the bit stream expected by WS2812 (and, with a white
+// channel, SK6812) LEDs when sent via SPI.  Each data bit becomes 3 or 4 SPI
+// bits (oversampling), a short pulse for 0 and a long one for 1, so with the
+// SPI clock at 3x or 4x the LED bit rate (2.4 or 3.2 MHz) the SPI data line
+// carries the LED waveform.  Each color byte is expanded with a single table
+// lookup, with the LED's color order applied on the way.
+class WS2812Encoder
+{
+  public:
+    WS2812Encoder(byte oversample, EOrder order = GRB, boolean rgbw = false);
+    size_t frameSize(int count);
+    void encode(const CRGB leds[], int first, int last, byte buffer[]);
+    boolean encode(LEDControl &strip, const CRGB leds[], byte buffer[]);
+    void stream(LEDControl &strip, int first, int count, byte out[]);
+  private:
+    byte _oversample;  // SPI bytes per color byte, 3 or 4
+    byte _channels;    // Color bytes per LED, 3 or 4 (RGBW)
+    byte _order[3];    // CRGB channel sent first, second, third
+};
+
+// Builds complete SPI frames for APA102 and SK9822 (clock and data) LEDs: a
+// start frame, a 4 byte frame per LED (header with 5-bit brightness, then the
+// three colors) and an end frame to clock the data through.  Colors can be
+// written straight into the frame, and the brightness field updated on its own
+// when the strip uses hardware dimming.
+class APA102Frame
+{
+  public:
+    APA102Frame(EOrder order = BGR);
+    size_t frameSize(int count);
+    void build(const CRGB leds[], int count, byte brightness, byte frame[]);
+    void setColors(const CRGB leds[], int first, int last, byte frame[]);
+    void setBrightness(int count, byte brightness, byte frame[]);
+    boolean build(LEDControl &strip, const CRGB leds[], int count, byte frame[]);
+    void stream(LEDControl &strip, int first, int count, byte out[]);
+  private:
+    byte _order[3];
+    byte _brightness;  // 5-bit brightness currently in the frame
+};
+
+#if defined(__linux__)
+// Writes frames to a file descriptor -- an SPI device (spidev), or for testing
+// a plain file or pipe.
+class LEDFdSink
+{
+  public:
+    LEDFdSink(int fd);
+    static int openSpi(const char *device, unsigned long speed);
+    boolean write(const byte data[], size_t length);
+  private:
+    int _fd;
+};
+#endif
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ * LED Pixel -- bulk hue conversion.  See LEDPixel.h
+ *
+ * Author: David Bryant <david@orangemoose.com>
+ */
+
+#include "Arduino.h"
+#include <FastLED.h>
+#include "LEDPixel.h"
+
+#if defined(__AVR__)
+
+CRGB led_hue(byte hue)
+{
+  return CHSV(hue,255,255);
+}
+
+void led_hsv2rgb(const CHSV *src, CRGB *dst, int count)
+{
+  hsv2rgb_rainbow(src,dst,count);
+}
+
+void led_rainbow(CRGB *dst, int count, byte hue, byte delta)
+{
+  for(int i=0;i<count;i++) {
+    dst[i] = CHSV(hue,255,255);
+    hue += delta;
+  }
+}
+
+#else
+
+static CRGB _hues[256];
+static boolean _huesBuilt = false;
+
+static const CRGB *hueTable()
+{
+  if(!_huesBuilt) {
+    for(int h=0;h<256;h++) hsv2rgb_rainbow(CHSV(h,255,255),_hues[h]);
+    _huesBuilt = true;
+  }
+  return _hues;
+}
+
+// Color for a fully saturated, full brightness hue
+CRGB led_hue(byte hue)
+{
+  return hueTable()[hue];
+}
+
+// Converts count colors, taking fully saturated full brightness ones from the
+// table and working out the rest as FastLED would
+void led_hsv2rgb(const CHSV *src, CRGB *dst, int count)
+{
+  const CRGB *table = hueTable();
+  for(int i=0;i<count;i++) {
+    if((src[i].s & src[i].v) == 255) dst[i] = table[src[i].h];
+    else hsv2rgb_rainbow(src[i],dst[i]);
+  }
+}
+
+// Fills count LEDs with evenly spaced hues, starting at hue and going up by
+// delta from one LED to the next
+void led_rainbow(CRGB *dst, int count, byte hue, byte delta)
+{
+  const CRGB *table = hueTable();
+  for(int i=0;i<count;i++) {
+    dst[i] = table[hue];
+    hue += delta;
+  }
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * LED Pixel -- pixel type policies for LED Control.
+ *
+ * Each policy describes how one kind of LED stores a pixel (single channel
+ * PWM, RGB, RGBW, 16-bit RGB) and how to convert to it from the CRGB colors
+ * LED Control works in.  The buffer kernels below are templates on the
+ * policy, so each pixel type gets its own compiled loop with no per-pixel
+ * branching on format.  LEDControl::renderPixels() uses them to render a
+ * strip straight into a buffer of any of these types.
+ *
+ * Author: David Bryant <david@orangemoose.com>
+ */
+
+#ifndef LEDPixel_h
+#define LEDPixel_h
+
+#include "Arduino.h"
+
+// Single channel LEDs (e.g. PWM driven single color arrays), one byte per LED.
+// Brightness comes from the brightest channel, so a pure red run on a mono
+// array is just as bright as a white one.
+struct PixelMono8
+{
+  typedef uint8_t pixel_t;
+  static pixel_t from(const CRGB &c) { return max(c.r,max(c.g,c.b)); }
+};
+
+// Regular RGB LEDs, i.e. FastLED's own CRGB
+struct PixelRGB
+{
+  typedef CRGB pixel_t;
+  static pixel_t from(const CRGB &c) { return c; }
+};
+
+// RGBW LEDs (SK6812 and friends).  Converting from RGB moves the part of the
+// color common to all three channels onto the white LED.
+struct CRGBW
+{
+  uint8_t r, g, b, w;
+};
+
+struct PixelRGBW
+{
+  typedef CRGBW pixel_t;
+  static pixel_t from(const CRGB &c) {
+    uint8_t w = min(c.r,min(c.g,c.b));
+    pixel_t p = { (uint8_t)(c.r - w), (uint8_t)(c.g - w), (uint8_t)(c.b - w), w };
+    return p;
+  }
+};
+
+// 16 bits per channel, for high dynamic range drivers.  8-bit values are
+// widened by repeating the byte so 255 maps to full scale (65535).
+struct CRGB16
+{
+  uint16_t r, g, b;
+};
+
+struct PixelRGB16
+{
+  typedef CRGB16 pixel_t;
+  static pixel_t from(const CRGB &c) {
+    pixel_t p = { (uint16_t)(c.r * 257U), (uint16_t)(c.g * 257U), (uint16_t)(c.b * 257U) };
+    return p;
+  }
+};
+
+// Rotates the pixels one place towards the end, the last wrapping to the first
+template<class P>
+void led_shiftFwd(typename P::pixel_t *leds, int count)
+{
+  if(count < 2) return;
+  typename P::pixel_t last = leds[count-1];
+  for(int i=count-1;i>0;i--) { leds[i] = leds[i-1]; }
+  leds[0] = last;
+}
+
+// Rotates the pixels one place towards the start, the first wrapping to the last
+template<class P>
+void led_shiftRev(typename P::pixel_t *leds, int count)
+{
+  if(count < 2) return;
+  typename P::pixel_t first = leds[0];
+  for(int i=0;i<count-1;i++) { leds[i] = leds[i+1]; }
+  leds[count-1] = first;
+}
+
+// Output pass -- converts count CRGB colors to the policy's pixel type
+template<class P>
+void led_convert(const CRGB *src, typename P::pixel_t *dst, int count)
+{
+  for(int i=0;i<count;i++) { dst[i] = P::from(src[i]); }
+}
+
+// Hue to color conversion in bulk, for rainbows, noise and the like.  Colors are
+// exactly what FastLED's own CHSV to CRGB conversion gives.  Except on AVR,
+// fully saturated full brightness hues come from a table of 256 colors made
+// with FastLED's conversion the first time one is needed; AVR boards can't
+// spare the RAM and use FastLED's hand tuned assembly conversion.
+CRGB led_hue(byte hue);
+void led_hsv2rgb(const CHSV *src, CRGB *dst, int count);
+void led_rainbow(CRGB *dst, int count, byte hue, byte delta);
+
+#endif
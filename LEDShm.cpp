@@ -0,0 +1,173 @@
+/*
+ * LED Shm -- shared memory frame output for Linux.  See LEDShm.h
+ *
+ * Author: David Bryant <david@orangemoose.com>
+ */
+
+#include "LEDShm.h"
+
+#if defined(__linux__)
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Slots start on cache line boundaries so the two sides never share a line
+static size_t slotSize(size_t frameSize)
+{
+  return (frameSize + 63) & ~(size_t)63;
+}
+
+static size_t headerSize()
+{
+  return (sizeof(LEDShmHeader) + 63) & ~(size_t)63;
+}
+
+LEDShmSink::LEDShmSink()
+{
+  _header = NULL;
+  _slots = NULL;
+  _back = 0;
+  _mapSize = 0;
+}
+
+LEDShmSink::~LEDShmSink()
+{
+  close();
+}
+
+// Creates (or takes over) the shared memory object called name, e.g. "/leds0",
+// sized for frames of frameSize bytes.  Returns false if it can't be set up.
+bool LEDShmSink::open(const char *name, size_t frameSize)
+{
+  close();
+  int fd = shm_open(name,O_RDWR | O_CREAT,0660);
+  if(fd < 0) return false;
+
+  size_t size = headerSize() + 3*slotSize(frameSize);
+  if(ftruncate(fd,size) < 0) {
+    ::close(fd);
+    return false;
+  }
+  void *map = mmap(NULL,size,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+  ::close(fd);
+  if(map == MAP_FAILED) return false;
+
+  _mapSize = size;
+  _header = (LEDShmHeader *)map;
+  _slots = (uint8_t *)map + headerSize();
+
+  // Publisher starts with slot 0, the reader with slot 2, and slot 1 (empty)
+  // in the middle.  magic goes in last so readers only see a complete header.
+  memset(_header,0,sizeof(LEDShmHeader));
+  _header->version = LEDSHM_VERSION;
+  _header->frameSize = frameSize;
+  _header->middle = 1;
+  _header->front = 2;
+  _back = 0;
+  __atomic_store_n(&_header->magic,LEDSHM_MAGIC,__ATOMIC_RELEASE);
+  return true;
+}
+
+void LEDShmSink::close()
+{
+  if(_header != NULL) munmap(_header,_mapSize);
+  _header = NULL;
+  _slots = NULL;
+}
+
+// The slot to write the next frame into, e.g. by an output stage's encoder
+uint8_t *LEDShmSink::frame()
+{
+  return _slots + _back*slotSize(_header->frameSize);
+}
+
+// Makes the frame written via frame() the newest one, and swaps in the slot the
+// previous newest frame was in (unless the reader took it) for the next frame
+void LEDShmSink::publish()
+{
+  uint32_t seq = __atomic_load_n(&_header->sequence,__ATOMIC_RELAXED) + 1;
+  _header->slotSeq[_back] = seq;
+  uint32_t old = __atomic_exchange_n(&_header->middle,_back | LEDSHM_FRESH,__ATOMIC_ACQ_REL);
+  _back = old & 0x3;
+  __atomic_store_n(&_header->sequence,seq,__ATOMIC_RELEASE);
+}
+
+// Copies in and publishes a frame that was built elsewhere
+void LEDShmSink::publish(const uint8_t data[], size_t length)
+{
+  if(length > _header->frameSize) length = _header->frameSize;
+  memcpy(frame(),data,length);
+  publish();
+}
+
+LEDShmSource::LEDShmSource()
+{
+  _header = NULL;
+  _slots = NULL;
+  _mapSize = 0;
+}
+
+LEDShmSource::~LEDShmSource()
+{
+  close();
+}
+
+// Attaches to frames being published under name.  Returns false if there's no
+// publisher (yet), or it isn't using a compatible layout.
+bool LEDShmSource::open(const char *name)
+{
+  close();
+  int fd = shm_open(name,O_RDWR,0);
+  if(fd < 0) return false;
+
+  struct stat st;
+  if(fstat(fd,&st) < 0 || (size_t)st.st_size < headerSize()) {
+    ::close(fd);
+    return false;
+  }
+  void *map = mmap(NULL,st.st_size,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+  ::close(fd);
+  if(map == MAP_FAILED) return false;
+
+  _mapSize = st.st_size;
+  _header = (LEDShmHeader *)map;
+  _slots = (uint8_t *)map + headerSize();
+  if(__atomic_load_n(&_header->magic,__ATOMIC_ACQUIRE) != LEDSHM_MAGIC ||
+     _header->version != LEDSHM_VERSION ||
+     headerSize() + 3*slotSize(_header->frameSize) > _mapSize) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void LEDShmSource::close()
+{
+  if(_header != NULL) munmap(_header,_mapSize);
+  _header = NULL;
+  _slots = NULL;
+}
+
+size_t LEDShmSource::frameSize()
+{
+  return _header->frameSize;
+}
+
+// Newest complete frame, which stays valid (and unchanged) until the next
+// call.  Sets *sequence to the frame's sequence number (0 if nothing has been
+// published yet), so callers can tell whether it's a new frame.
+const uint8_t *LEDShmSource::latest(uint32_t *sequence)
+{
+  uint32_t front = _header->front;
+  if(__atomic_load_n(&_header->middle,__ATOMIC_ACQUIRE) & LEDSHM_FRESH) {
+    front = __atomic_exchange_n(&_header->middle,front,__ATOMIC_ACQ_REL) & 0x3;
+    _header->front = front;
+  }
+  if(sequence != NULL) *sequence = _header->slotSeq[front];
+  return _slots + front*slotSize(_header->frameSize);
+}
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * LED Shm -- publishes LED frames through POSIX shared memory on Linux, for
+ * setups where a separate (often privileged) process owns the LED hardware.
+ *
+ * Frames go through a triple buffer: the publisher always has a slot of its
+ * own to write into, the reader always has a slot of its own to read from, and
+ * the third slot holds the newest complete frame.  Handing slots over is a
+ * single atomic exchange on each side, so neither side ever waits on a lock,
+ * the reader always gets the latest complete frame, and neither side copies
+ * frame data.
+ *
+ * Doesn't depend on FastLED or Arduino, so the driver process can use it as is.
+ *
+ * Author: David Bryant <david@orangemoose.com>
+ */
+
+#ifndef LEDShm_h
+#define LEDShm_h
+
+#if defined(__linux__)
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LEDSHM_MAGIC    0x5344454CUL  // "LEDS"
+#define LEDSHM_VERSION  1
+#define LEDSHM_FRESH    0x4           // Flags the middle slot as not yet read
+
+// Layout at the start of the shared memory, followed by three frame slots
+struct LEDShmHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t frameSize;    // Bytes in each slot
+  uint32_t middle;       // Slot with the newest frame, plus LEDSHM_FRESH (atomic)
+  uint32_t sequence;     // Frames published so far (atomic)
+  uint32_t front;        // Slot the reader owns (only touched by the reader)
+  uint32_t slotSeq[3];   // Sequence number of the frame in each slot
+};
+
+// Publisher side, used by the process running the animations
+class LEDShmSink
+{
+  public:
+    LEDShmSink();
+    ~LEDShmSink();
+    bool open(const char *name, size_t frameSize);
+    void close();
+    uint8_t *frame();
+    void publish();
+    void publish(const uint8_t data[], size_t length);
+  private:
+    LEDShmHeader *_header;
+    uint8_t *_slots;
+    uint32_t _back;  // Slot being written
+    size_t _mapSize;
+};
+
+// Reader side, used by the driver process
+class LEDShmSource
+{
+  public:
+    LEDShmSource();
+    ~LEDShmSource();
+    bool open(const char *name);
+    void close();
+    const uint8_t *latest(uint32_t *sequence);
+    size_t frameSize();
+  private:
+    LEDShmHeader *_header;
+    uint8_t *_slots;
+    size_t _mapSize;
+};
+
+#endif
+#endif
@@ -0,0 +1,38 @@
+#include <FastLED.h>
+#include <LEDControl.h>
+#include "sprite.h"
+
+// Measures how many animation frames per second LED Control can decode.  The
+// animation in sprite.h (a sprite bouncing over a moving striped background,
+// 30 frames of 40 LEDs) was made with extras/anim_encode:
+//
+//   anim_encode.py --leds 40 --name sprite sprite.rgb sprite.h
+
+#define NUM_LEDS  40
+#define PASSES    300
+
+CRGB leds[NUM_LEDS];
+LEDControl strip(NUM_LEDS,leds);
+
+void setup() {
+  Serial.begin(115200);
+  strip.setAnimation(sprite);
+  strip.update();
+
+  // Playing forwards, each frame is decoded from the one before it
+  unsigned long start = micros();
+  for(int i=0;i<PASSES;i++) {
+    strip.update();
+  }
+  unsigned long elapsed = micros() - start;
+  Serial.print("Playback: ");
+  Serial.print(elapsed/PASSES); Serial.print(" us/frame, ");
+  Serial.print(PASSES / (elapsed/1000000.0)); Serial.println(" frames/s");
+
+  Serial.print("Compressed size: ");
+  Serial.print(sizeof(sprite)); Serial.print(" bytes, raw ");
+  Serial.print(30L*NUM_LEDS*3); Serial.println(" bytes");
+}
+
+void loop() {
+}
@@ -0,0 +1,32 @@
+// Generated by anim_encode.py
+const byte sprite[] PROGMEM = {
+  0x4C,0x41,0x01,0x28,0x00,0x1E,0x00,0x05,0x00,0x00,0x00,0x00,0x00,0x14,0xFF,0x00,
+  0x00,0xFF,0x3C,0x00,0xFF,0x78,0x00,0x43,0x02,0x03,0x04,0x01,0x03,0x00,0x03,0x01,
+  0x03,0x00,0x03,0x01,0x03,0x00,0x03,0x01,0x03,0x00,0x03,0x01,0x03,0x00,0x43,0x03,
+  0x02,0x03,0x04,0xA3,0x44,0x04,0x03,0x02,0x03,0x04,0xA2,0x46,0x01,0x04,0x03,0x02,
+  0x03,0x04,0x00,0x03,0x01,0x03,0x00,0x03,0x01,0x03,0x00,0x03,0x01,0x03,0x00,0x03,
+  0x01,0x03,0x00,0x40,0x01,0x80,0x45,0x01,0x04,0x03,0x02,0x03,0x04,0xA0,0x81,0x45,
+  0x01,0x04,0x03,0x02,0x03,0x04,0x9F,0x81,0x01,0x00,0x45,0x04,0x03,0x02,0x03,0x04,
+  0x01,0x03,0x00,0x03,0x01,0x03,0x00,0x03,0x01,0x03,0x00,0x03,0x01,0x03,0x00,0x01,
+  0x01,0x83,0x45,0x00,0x04,0x03,0x02,0x03,0x04,0x9D,0x84,0x45,0x00,0x04,0x03,0x02,
+  0x03,0x04,0x9C,0x80,0x03,0x00,0x01,0x01,0x45,0x04,0x03,0x02,0x03,0x04,0x00,0x03,
+  0x01,0x03,0x00,0x03,0x01,0x03,0x00,0x03,0x01,0x03,0x00,0x02,0x01,0x86,0x45,0x01,
+  0x04,0x03,0x02,0x03,0x04,0x9A,0x87,0x45,0x01,0x04,0x03,0x02,0x03,0x04,0x99,0x03,
+  0x00,0x03,0x01,0x01,0x00,0x45,0x04,0x03,0x02,0x03,0x04,0x01,0x03,0x00,0x03,0x01,
+  0x03,0x00,0x03,0x01,0x03,0x00,0x03,0x01,0x89,0x45,0x00,0x04,0x03,0x02,0x03,0x04,
+  0x97,0x8A,0x45,0x00,0x04,0x03,0x02,0x03,0x04,0x96,0x82,0x03,0x01,0x03,0x00,0x01,
+  0x01,0x45,0x04,0x03,0x02,0x03,0x04,0x00,0x03,0x01,0x03,0x00,0x03,0x01,0x03,0x00,
+  0x03,0x01,0x40,0x00,0x8C,0x45,0x01,0x04,0x03,0x02,0x03,0x04,0x94,0x8D,0x45,0x01,
+  0x04,0x03,0x02,0x03,0x04,0x93,0x81,0x03,0x01,0x03,0x00,0x03,0x01,0x01,0x00,0x45,
+  0x04,0x03,0x02,0x03,0x04,0x01,0x03,0x00,0x03,0x01,0x03,0x00,0x03,0x01,0x01,0x00,
+  0x8F,0x45,0x00,0x04,0x03,0x02,0x03,0x04,0x91,0x90,0x45,0x00,0x04,0x03,0x02,0x03,
+  0x04,0x90,0x80,0x03,0x01,0x03,0x00,0x03,0x01,0x03,0x00,0x44,0x04,0x03,0x02,0x03,
+  0x04,0x02,0x00,0x03,0x01,0x03,0x00,0x03,0x01,0x02,0x00,0x8F,0x44,0x04,0x03,0x02,
+  0x03,0x04,0x03,0x00,0x8E,0x8E,0x45,0x04,0x03,0x02,0x03,0x04,0x01,0x92,0x03,0x01,
+  0x03,0x00,0x03,0x01,0x01,0x00,0x45,0x04,0x03,0x02,0x03,0x04,0x01,0x03,0x00,0x03,
+  0x01,0x03,0x00,0x03,0x01,0x03,0x00,0x8C,0x45,0x04,0x03,0x02,0x03,0x04,0x01,0x94,
+  0x8B,0x44,0x04,0x03,0x02,0x03,0x04,0x02,0x01,0x93,0x82,0x03,0x00,0x03,0x01,0x44,
+  0x04,0x03,0x02,0x03,0x04,0x02,0x01,0x03,0x00,0x03,0x01,0x03,0x00,0x03,0x01,0x03,
+  0x00,0x40,0x01,0x89,0x44,0x04,0x03,0x02,0x03,0x04,0x03,0x01,0x94,0x88,0x45,0x04,
+  0x03,0x02,0x03,0x04,0x00,0x98
+};
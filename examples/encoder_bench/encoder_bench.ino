@@ -0,0 +1,48 @@
+#include <FastLED.h>
+#include <LEDControl.h>
+#include <LEDOutput.h>
+
+// Measures how fast WS2812Encoder can turn LED colors into SPI waveform data.
+// Meant for boards with plenty of RAM (e.g. Linux single board computers),
+// where a 1000 LED strip at 4x oversampling needs a 12KB SPI buffer.
+
+#define NUM_LEDS    1000
+#define OVERSAMPLE  4
+#define PASSES      100
+
+CRGB leds[NUM_LEDS];
+LEDControl strip(NUM_LEDS,leds);
+WS2812Encoder encoder(OVERSAMPLE,GRB);
+byte spiBuffer[NUM_LEDS*3*OVERSAMPLE];
+
+void setup() {
+  Serial.begin(115200);
+  strip.setRainbowFwd();
+  strip.update();
+
+  // Full frames, as if every LED changed every tick
+  unsigned long start = micros();
+  for(int i=0;i<PASSES;i++) {
+    encoder.encode(leds,0,NUM_LEDS-1,spiBuffer);
+  }
+  unsigned long elapsed = micros() - start;
+  float mbytes = (float)encoder.frameSize(NUM_LEDS) * PASSES / 1000000.0;
+  Serial.print("Full frame encode: ");
+  Serial.print(elapsed/PASSES); Serial.print(" us/frame, ");
+  Serial.print(mbytes / (elapsed/1000000.0)); Serial.println(" MB/s");
+
+  // Incremental, re-encoding only what each update changed.  A static
+  // pattern only gets encoded once.
+  strip.setOneColor(CRGB::Blue);
+  start = micros();
+  for(int i=0;i<PASSES;i++) {
+    strip.update();
+    encoder.encode(strip,leds,spiBuffer);
+  }
+  elapsed = micros() - start;
+  Serial.print("Incremental (static pattern): ");
+  Serial.print(elapsed/PASSES); Serial.println(" us/frame");
+}
+
+void loop() {
+}
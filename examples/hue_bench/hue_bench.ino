@@ -0,0 +1,51 @@
+#include <FastLED.h>
+#include <LEDControl.h>
+#include <LEDPixel.h>
+
+// Measures how fast hues are turned into colors, one at a time as FastLED does
+// and in bulk with led_hsv2rgb(), in pixels per microsecond, along with how
+// long a rainbow takes to draw.  Needs about 1.5KB of RAM for the buffers.
+
+#define NUM_LEDS  256
+#define PASSES    100
+
+CHSV hsv[NUM_LEDS];
+CRGB leds[NUM_LEDS];
+LEDControl strip(NUM_LEDS,leds);
+
+static void report(const char *what, unsigned long elapsed) {
+  Serial.print(what);
+  Serial.print((float)NUM_LEDS * PASSES / elapsed);
+  Serial.println(" pixels/us");
+}
+
+void setup() {
+  Serial.begin(115200);
+  for(int i=0;i<NUM_LEDS;i++) hsv[i] = CHSV(i*7,255,255);
+  led_hsv2rgb(hsv,leds,NUM_LEDS);  // Builds the hue table (if any) up front
+
+  unsigned long start = micros();
+  for(int p=0;p<PASSES;p++) {
+    for(int i=0;i<NUM_LEDS;i++) leds[i] = hsv[i];
+  }
+  report("One at a time: ",micros() - start);
+
+  start = micros();
+  for(int p=0;p<PASSES;p++) {
+    led_hsv2rgb(hsv,leds,NUM_LEDS);
+  }
+  report("led_hsv2rgb(): ",micros() - start);
+
+  // Rainbows are drawn from scratch when they're started or jump (seek()),
+  // so time that
+  strip.setRainbowFwd();
+  strip.update();
+  start = micros();
+  for(int p=0;p<PASSES;p++) {
+    strip.seek(p*3);
+  }
+  report("Rainbow redraw: ",micros() - start);
+}
+
+void loop() {
+}
@@ -0,0 +1,52 @@
+#include <FastLED.h>
+#include <LEDControl.h>
+
+// Reports how much RAM each LEDControl takes and how long it takes to update
+// a large group of strips, e.g. for installations with dozens of strips.  Only
+// a few of the strips use overlays and transitions, so only those few are
+// given an LEDExtras block for them; the rest just hold a NULL pointer.
+
+#define NUM_STRIPS  40
+#define NUM_LEDS    16
+#define NUM_EXTRAS  4
+#define PASSES      100
+
+CRGB leds[NUM_STRIPS][NUM_LEDS];
+LEDControl *strips[NUM_STRIPS];
+LEDExtras extras[NUM_EXTRAS];
+
+void setup() {
+  Serial.begin(115200);
+
+  for(int i=0;i<NUM_STRIPS;i++) {
+    strips[i] = new LEDControl(NUM_LEDS,leds[i]);
+    if(i < NUM_EXTRAS) strips[i]->setExtras(&extras[i]);
+    switch(i % 4) {
+      case 0: strips[i]->setCylon(CRGB::Red); break;
+      case 1: strips[i]->setMarquee(CRGB::Yellow,0b1100110011001100); break;
+      case 2: strips[i]->setBreathe(CRGB::Purple); break;
+      case 3: strips[i]->setOneColor(CRGB::Blue); break;
+    }
+    strips[i]->update();
+  }
+  // The strips with extras can show a notification and fade between colors
+  strips[0]->pushOverlay(1,CRGB::Green,50,5,5);
+  strips[3]->tweenColor(CRGB::Orange,100);
+
+  Serial.print("RAM per strip: "); Serial.print(sizeof(LEDControl));
+  Serial.print(" bytes, plus "); Serial.print(sizeof(LEDExtras));
+  Serial.println(" bytes for a strip with extras");
+  Serial.print("All "); Serial.print(NUM_STRIPS); Serial.print(" strips, ");
+  Serial.print(NUM_EXTRAS); Serial.print(" with extras: ");
+  Serial.print(sizeof(LEDControl)*NUM_STRIPS + sizeof(extras)); Serial.println(" bytes");
+
+  unsigned long start = micros();
+  for(int p=0;p<PASSES;p++) {
+    for(int i=0;i<NUM_STRIPS;i++) strips[i]->update();
+  }
+  unsigned long elapsed = micros() - start;
+  Serial.print("Updating all strips: "); Serial.print(elapsed/PASSES); Serial.println(" us");
+}
+
+void loop() {
+}
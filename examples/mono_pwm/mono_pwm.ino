@@ -0,0 +1,31 @@
+#include <FastLED.h>
+#include <LEDControl.h>
+
+// Runs a Cylon across a row of single color LEDs driven straight from PWM pins.
+// The strip has no CRGB array: each update renders just the LEDs that changed
+// into one brightness byte per LED (PixelMono8), which is all a mono array
+// needs.
+
+#define NUM_LEDS  6
+
+const byte pins[NUM_LEDS] = {3,5,6,9,10,11};  // PWM pins on an Uno
+byte levels[NUM_LEDS];
+LEDControl strip(NUM_LEDS,NULL);
+
+void setup() {
+  for(int i=0;i<NUM_LEDS;i++) pinMode(pins[i],OUTPUT);
+  strip.setCylon(CRGB::Red);  // Mono LEDs light at the color's brightest channel
+}
+
+void loop() {
+  strip.update();
+
+  int first, last;
+  if(strip.getDirty(first,last)) {
+    strip.renderPixels<PixelMono8>(levels+first,first,last-first+1);
+    for(int i=first;i<=last;i++) analogWrite(pins[i],levels[i]);
+    strip.clearDirty();
+  }
+
+  delay(100);
+}
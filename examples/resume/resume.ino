@@ -0,0 +1,51 @@
+#include <EEPROM.h>
+#include <FastLED.h>
+#include <LEDControl.h>
+
+// Picks up the animation where it left off after a reset or power loss,
+// rather than starting over.  The strip's state is kept in EEPROM, saved only
+// when the animation settings change and at most every 10 seconds, so the
+// EEPROM isn't worn out.
+
+#define NUM_LEDS    16
+#define DATA_PIN    10
+#define STATE_ADDR  0        // Where in EEPROM to keep the strip's state
+#define SAVE_EVERY  10000UL  // Milliseconds between saves, at most
+
+CRGB leds[NUM_LEDS];
+LEDControl strip(NUM_LEDS,leds);
+LEDExtras extras;  // Where the strip remembers its last save, for needsSave()
+
+void setup() {
+  Serial.begin(115200);
+  FastLED.addLeds<WS2812B, DATA_PIN, GRB>(leds,NUM_LEDS);
+  strip.setExtras(&extras);
+
+  // Resume from the saved state if there is one, otherwise start fresh
+  byte state[LED_STATE_SIZE];
+  for(int i=0;i<LED_STATE_SIZE;i++) state[i] = EEPROM.read(STATE_ADDR+i);
+  if(!strip.restoreState(state)) {
+    Serial.println("No saved state, starting over");
+    strip.setCylon(CRGB::Red);
+  }
+}
+
+unsigned int counter = 0;
+
+void loop() {
+  // Change animation every 200 ticks
+  if(++counter % 200 == 0) {
+    if(strip.getMode() == MODE_CYLON) strip.setMarquee(CRGB::Yellow,0b1100110011001100);
+    else strip.setCylon(CRGB::Red);
+  }
+
+  strip.update();
+  FastLED.show();
+
+  if(strip.needsSave(SAVE_EVERY)) {
+    byte state[LED_STATE_SIZE];
+    strip.saveState(state);
+    for(int i=0;i<LED_STATE_SIZE;i++) EEPROM.update(STATE_ADDR+i,state[i]);  // Only writes changed bytes
+  }
+  delay(100);
+}
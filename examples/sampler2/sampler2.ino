@@ -33,60 +33,58 @@ void setup() {
 }
 
 unsigned int counter = 0;
+LEDBatch batch;
 
 void loop() {
 
   int i, level_leds, progress;
   unsigned long bitmap;
 
-  // Cycle through patterns, with 64 updates for each
+  // Cycle through patterns, with 64 updates for each.  Changes for both strips
+  // go in a batch so they take effect on the same tick.
   if( (counter % 64) == 0) {
+    batch.clear();
     switch((counter/64)%7) {
       case 0:
-        stripOne.setRunFwd(CRGB::Green);
-        stripTwo.setRunFwd(CRGB::Orange); 
+        batch.add(stripOne,MODE_RUNFWD,CRGB::Green);
+        batch.add(stripTwo,MODE_RUNFWD,CRGB::Orange);
         break;
         
       case 1:
-        stripOne.setRunRev(CRGB::Orange);       
-        stripTwo.setRunRev(CRGB::Green);
+        batch.add(stripOne,MODE_RUNREV,CRGB::Orange);
+        batch.add(stripTwo,MODE_RUNREV,CRGB::Green);
         break;
         
       case 2:
-        stripOne.setRainbowFwd();
-        stripTwo.setRainbowRev();
+        batch.add(stripOne,MODE_RAINBF,CRGB::Black);
+        batch.add(stripTwo,MODE_RAINBR,CRGB::Black);
         break;
 
       case 3:
-        stripOne.setCylon(CRGB::Red);
-        stripTwo.setCylon(CRGB::Red);
+        batch.add(stripOne,MODE_CYLON,CRGB::Red);
+        batch.add(stripTwo,MODE_CYLON,CRGB::Red);
         break;
  
       case 4:
         bitmap = 0b1100110011001100;  // marquee 
 
-        stripOne.setMarquee(CRGB::Yellow,bitmap); 
-        stripTwo.setMarquee(CRGB::Blue,bitmap);
+        batch.add(stripOne,MODE_MARQUEE,CRGB::Yellow,bitmap);
+        batch.add(stripTwo,MODE_MARQUEE,CRGB::Blue,bitmap);
         break;
    
       case 5: // Side-by-side comparison of breathing...
-        stripOne.setBreathe(CRGB::Purple);
-        stripTwo.setOneColor(CRGB::Purple);
-        break;
-        
       case 6: // ...for two cycles, just for emphasis
-        stripOne.setBreathe(CRGB::Purple);  
-        stripTwo.setOneColor(CRGB::Purple);
+        batch.add(stripOne,MODE_BREATHE,CRGB::Purple);
+        batch.add(stripTwo,MODE_ON,CRGB::Purple);
         break;
         
-      default: stripOne.setOneColor(CRGB::Orange); break;  // should never see this
+      default: batch.add(stripOne,MODE_ON,CRGB::Orange); break;  // should never see this
     }
+    batch.commit();  // Applied by showAll() below
   }
   counter++;
   
-  stripOne.update();
-  stripTwo.update();
-  FastLED.show();
+  LEDControl::showAll();  // Updates both strips, then shows them
   delay(100);
   
 }
@@ -0,0 +1,40 @@
+#include <SPI.h>
+#include <FastLED.h>
+#include <LEDControl.h>
+#include <LEDOutput.h>
+
+// Drives a long APA102 strip with no LED array at all: the strip's colors are
+// worked out a few LEDs at a time just as they're sent over SPI, so RAM use
+// doesn't grow with the number of LEDs.  Fits boards with very little RAM
+// (e.g. an ATmega with 512 bytes), with the APA102 data and clock lines on the
+// board's hardware SPI pins.
+
+#define NUM_LEDS  300
+#define CHUNK     8     // LEDs sent at a time
+
+LEDControl strip(NUM_LEDS,NULL);
+APA102Frame frame;
+byte buffer[CHUNK*4];
+
+void setup() {
+  SPI.begin();
+  strip.setHardwareDimming(true);  // Breathe via the APA102 brightness field
+  strip.setBreathe(CRGB::Teal);
+}
+
+void loop() {
+  strip.update();
+
+  SPI.beginTransaction(SPISettings(4000000,MSBFIRST,SPI_MODE0));
+  for(int i=0;i<4;i++) SPI.transfer(0x00);  // Start frame
+  for(int first=0;first<NUM_LEDS;first+=CHUNK) {
+    int n = min(CHUNK,NUM_LEDS-first);
+    frame.stream(strip,first,n,buffer);
+    SPI.transfer(buffer,n*4);
+  }
+  int end = frame.frameSize(NUM_LEDS) - 4 - NUM_LEDS*4;
+  for(int i=0;i<end;i++) SPI.transfer(0xFF);  // End frame
+  SPI.endTransaction();
+
+  delay(20);
+}
@@ -0,0 +1,41 @@
+#include <FastLED.h>
+#include <LEDControl.h>
+#include <LEDFrameMap.h>
+
+// Measures full-wall update throughput for a very large installation, with
+// every strip's LEDs living in one memory mapping (Linux only).  Other
+// processes can watch the wall by mapping the same file.
+
+#define NUM_STRIPS      1000
+#define LEDS_PER_STRIP  1000
+#define PASSES          20
+
+LEDFrameMap wall;
+LEDControl *strips[NUM_STRIPS];
+
+void setup() {
+  Serial.begin(115200);
+
+  if(!wall.open("/dev/shm/led_wall",(long)NUM_STRIPS*LEDS_PER_STRIP)) {
+    Serial.println("Can't map LED wall");
+    return;
+  }
+  for(int i=0;i<NUM_STRIPS;i++) {
+    strips[i] = new LEDControl(LEDS_PER_STRIP,wall.leds((long)i*LEDS_PER_STRIP));
+    strips[i]->setRainbowFwd();
+    strips[i]->update();
+  }
+
+  unsigned long start = micros();
+  for(int p=0;p<PASSES;p++) {
+    for(int i=0;i<NUM_STRIPS;i++) strips[i]->update();
+  }
+  unsigned long elapsed = micros() - start;
+  float pixels = (float)NUM_STRIPS * LEDS_PER_STRIP * PASSES;
+  Serial.print("Full wall update: ");
+  Serial.print(elapsed/PASSES); Serial.print(" us/frame, ");
+  Serial.print(pixels / elapsed); Serial.println(" Mpixels/s");
+}
+
+void loop() {
+}
@@ -0,0 +1,50 @@
+#include <FastLED.h>
+#include <LEDControl.h>
+
+// Measures how fast the Wave effect draws, with one wave and with two added
+// together, against working out each LED's brightness with sin() as a naive
+// version would.  Results are in LEDs per microsecond.
+
+#define NUM_LEDS  150
+#define PASSES    100
+
+CRGB leds[NUM_LEDS];
+LEDControl strip(NUM_LEDS,leds);
+
+static void report(const char *what, unsigned long elapsed) {
+  Serial.print(what);
+  Serial.print((float)NUM_LEDS * PASSES / elapsed);
+  Serial.println(" LEDs/us");
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  // Ocean: a deep blue swell that never goes fully dark
+  strip.setWave(CRGB(0,60,255),12,-5,40);
+  strip.update();
+  unsigned long start = micros();
+  for(int p=0;p<PASSES;p++) strip.update();
+  report("One wave: ",micros() - start);
+
+  // ...with ripples on top
+  strip.addWave(40,9);
+  strip.update();
+  start = micros();
+  for(int p=0;p<PASSES;p++) strip.update();
+  report("Two waves: ",micros() - start);
+
+  // Floating point sin() for every LED
+  start = micros();
+  for(int p=0;p<PASSES;p++) {
+    for(int i=0;i<NUM_LEDS;i++) {
+      float level = 0.5 + 0.5*sin(2*PI*(i*12 - p*5)/256.0);
+      leds[i] = CRGB(0,60,255);
+      leds[i] %= 40 + level*215;
+    }
+  }
+  report("Naive sin(): ",micros() - start);
+}
+
+void loop() {
+}
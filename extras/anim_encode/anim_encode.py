@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""
+anim_encode -- converts raw RGB frames into LED Control's compressed animation
+format (see LEDAnim.h), for playing with LEDControl::setAnimation().
+
+Input is raw 24-bit RGB, one frame after another with 3 bytes per LED, as
+written by most image tools -- e.g. a strip's worth of video from ffmpeg:
+
+  ffmpeg -i clip.mp4 -vf scale=60:1 -f rawvideo -pix_fmt rgb24 clip.rgb
+  anim_encode.py --leds 60 clip.rgb clip.anim
+
+With --name the output is instead a C header declaring a PROGMEM array of that
+name, to include in a sketch:
+
+  anim_encode.py --leds 60 --name clip clip.rgb clip.h
+
+Animations with more than 256 distinct colors are reduced to 256 by dropping
+low order color bits until they fit.
+"""
+
+import argparse
+import sys
+
+VERSION = 1
+MAX_COUNT = 64
+MAX_FRAMES = 32767
+
+
+def read_frames(path, leds):
+    with open(path, 'rb') as f:
+        raw = f.read()
+    size = leds * 3
+    if len(raw) == 0 or len(raw) % size != 0:
+        sys.exit('%s: not a whole number of %d LED frames' % (path, leds))
+    return [[tuple(raw[i:i+3]) for i in range(start, start + size, 3)]
+            for start in range(0, len(raw), size)]
+
+
+def build_palette(frames):
+    """Returns the palette and each frame as palette indexes"""
+    for bits in range(0, 8):
+        mask = (0xFF << bits) & 0xFF
+        quantized = [[(r & mask, g & mask, b & mask) for r, g, b in frame]
+                     for frame in frames]
+        colors = sorted(set(c for frame in quantized for c in frame))
+        if len(colors) <= 256:
+            if bits:
+                sys.stderr.write('%d bits per channel used to fit 256 colors\n'
+                                 % (8 - bits))
+            index = dict((c, i) for i, c in enumerate(colors))
+            return colors, [[index[c] for c in frame] for frame in quantized]
+
+
+def encode_frame(cur, prev):
+    """Ops for one frame, skipping LEDs unchanged since prev (if any)"""
+    out = bytearray()
+    n = len(cur)
+    i = 0
+
+    def unchanged(j):
+        return prev is not None and cur[j] == prev[j]
+
+    def run_length(j):
+        k = j
+        while k < n and k - j < MAX_COUNT and cur[k] == cur[j]:
+            k += 1
+        return k - j
+
+    while i < n:
+        if unchanged(i):
+            k = i
+            while k < n and k - i < MAX_COUNT and unchanged(k):
+                k += 1
+            out.append(0x80 | (k - i - 1))
+            i = k
+            continue
+        r = run_length(i)
+        if r >= 2:
+            out += bytes([r - 1, cur[i]])
+            i += r
+            continue
+        # Literal, until a run or skip would do better
+        k = i
+        while k < n and k - i < MAX_COUNT:
+            if k > i and (run_length(k) >= 3 or
+                          (unchanged(k) and k + 1 < n and unchanged(k + 1))):
+                break
+            k += 1
+        out.append(0x40 | (k - i - 1))
+        out += bytes(cur[i:k])
+        i = k
+    return out
+
+
+def decode(data):
+    """Decodes an animation back to palette colors, to check the encoder"""
+    leds = data[3] | (data[4] << 8)
+    frames = data[5] | (data[6] << 8)
+    ncolors = data[7] or 256
+    palette = [tuple(data[8+3*k:11+3*k]) for k in range(ncolors)]
+    pos = 8 + 3 * ncolors
+    shown = [(0, 0, 0)] * leds
+    result = []
+    for _ in range(frames):
+        i = 0
+        while i < leds:
+            op = data[pos]
+            pos += 1
+            count = (op & 0x3F) + 1
+            if op & 0xC0 == 0x00:
+                shown[i:i+count] = [palette[data[pos]]] * count
+                pos += 1
+            elif op & 0xC0 == 0x40:
+                shown[i:i+count] = [palette[c] for c in data[pos:pos+count]]
+                pos += count
+            i += count
+        result.append(list(shown))
+    return result
+
+
+def encode(frames):
+    if len(frames) > MAX_FRAMES:
+        sys.exit('too many frames (at most %d)' % MAX_FRAMES)
+    leds = len(frames[0])
+    colors, indexed = build_palette(frames)
+
+    out = bytearray(b'LA')
+    out.append(VERSION)
+    out += bytes([leds & 0xFF, leds >> 8, len(frames) & 0xFF, len(frames) >> 8])
+    out.append(len(colors) & 0xFF)
+    for c in colors:
+        out += bytes(c)
+    prev = None
+    for frame in indexed:
+        out += encode_frame(frame, prev)
+        prev = frame
+
+    if decode(out) != [[colors[i] for i in frame] for frame in indexed]:
+        sys.exit('internal error: animation does not decode back to its frames')
+    return out
+
+
+def write_header(out, name, data):
+    out.write('// Generated by anim_encode.py\n')
+    out.write('const byte %s[] PROGMEM = {\n' % name)
+    for start in range(0, len(data), 16):
+        out.write('  ' + ','.join('0x%02X' % b for b in data[start:start+16]))
+        out.write(',\n' if start + 16 < len(data) else '\n')
+    out.write('};\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().split('\n')[0])
+    parser.add_argument('--leds', type=int, required=True, help='LEDs per frame')
+    parser.add_argument('--name', help='write a C header declaring this array')
+    parser.add_argument('input', help='raw RGB frames')
+    parser.add_argument('output', help='animation file (or header with --name)')
+    args = parser.parse_args()
+
+    frames = read_frames(args.input, args.leds)
+    data = encode(frames)
+    if args.name:
+        with open(args.output, 'w') as f:
+            write_header(f, args.name, data)
+    else:
+        with open(args.output, 'wb') as f:
+            f.write(data)
+    raw = len(frames) * args.leds * 3
+    sys.stderr.write('%d frames, %d bytes (%.1f%% of raw)\n'
+                     % (len(frames), len(data), 100.0 * len(data) / raw))
+
+
+if __name__ == '__main__':
+    main()
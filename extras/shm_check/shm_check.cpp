@@ -0,0 +1,84 @@
+/*
+ * shm_check -- exercises LEDShm's triple buffer between two processes.
+ *
+ * Forks a consumer that reads frames as fast as it can while the parent
+ * publishes frames as fast as it can, each filled with a pattern derived from
+ * its sequence number.  The consumer checks every frame it sees is complete
+ * (matches the pattern for its sequence number) and that sequence numbers
+ * never go backwards.
+ *
+ * Build on Linux from the library directory with:
+ *   g++ -O2 -I. extras/shm_check/shm_check.cpp LEDShm.cpp -o shm_check -lrt
+ *
+ * Usage: shm_check [frames [frame_bytes]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "LEDShm.h"
+
+#define SHM_NAME "/ledshm_check"
+
+static uint8_t pattern(uint32_t seq, size_t i)
+{
+  return (uint8_t)(seq * 31 + i);
+}
+
+static int consume(uint32_t frames)
+{
+  LEDShmSource source;
+  while(!source.open(SHM_NAME)) usleep(1000);
+
+  size_t size = source.frameSize();
+  uint32_t last = 0, seen = 0, errors = 0;
+  while(last < frames) {
+    uint32_t seq;
+    const uint8_t *frame = source.latest(&seq);
+    if(seq == last) continue;
+    if(seq < last) {
+      printf("consumer: sequence went backwards (%u after %u)\n",seq,last);
+      errors++;
+    }
+    for(size_t i=0;i<size;i++) {
+      if(frame[i] != pattern(seq,i)) {
+        printf("consumer: frame %u torn at byte %zu\n",seq,i);
+        errors++;
+        break;
+      }
+    }
+    last = seq;
+    seen++;
+  }
+  printf("consumer: %u of %u frames seen, %u errors\n",seen,frames,errors);
+  return errors ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+  uint32_t frames = (argc > 1) ? atoi(argv[1]) : 100000;
+  size_t size = (argc > 2) ? atoi(argv[2]) : 3*1000;
+
+  shm_unlink(SHM_NAME);
+  LEDShmSink sink;
+  if(!sink.open(SHM_NAME,size)) {
+    perror("shm_check: can't create shared memory");
+    return 1;
+  }
+
+  pid_t pid = fork();
+  if(pid == 0) return consume(frames);
+
+  for(uint32_t seq=1;seq<=frames;seq++) {
+    uint8_t *frame = sink.frame();
+    for(size_t i=0;i<size;i++) frame[i] = pattern(seq,i);
+    sink.publish();
+  }
+
+  int status;
+  waitpid(pid,&status,0);
+  shm_unlink(SHM_NAME);
+  return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}